@@ -0,0 +1,253 @@
+#include "AnnounceScheduler.h"
+#include "TrackerList.h"
+#include <algorithm>
+#include <utility>
+
+AnnounceScheduler::AnnounceScheduler()
+    : m_random(static_cast<std::minstd_rand::result_type>(
+          std::chrono::steady_clock::now().time_since_epoch().count()))
+{
+}
+
+void AnnounceScheduler::setHold(std::function<bool(const std::string& url)> hold) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hold = std::move(hold);
+}
+
+void AnnounceScheduler::stash(const lt::sha1_hash& key, std::vector<lt::announce_entry> trackers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stash[key] = std::move(trackers);
+}
+
+std::vector<lt::announce_entry> AnnounceScheduler::schedule(const lt::torrent_handle& handle, const lt::sha1_hash& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_stash.find(key);
+    if (it == m_stash.end()) {
+        return {};
+    }
+    std::vector<lt::announce_entry> trackers = std::move(it->second);
+    m_stash.erase(it);
+
+    if (!trackers.empty()) {
+        Pending& pending = m_waiting[handle];
+        pending.trackers = trackers;
+        queueNextTier(handle, pending);
+    }
+    return trackers;
+}
+
+void AnnounceScheduler::dropStash(const lt::sha1_hash& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stash.erase(key);
+}
+
+void AnnounceScheduler::forget(const lt::torrent_handle& handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_waiting.erase(handle);
+    m_scraped.erase(handle);
+}
+
+void AnnounceScheduler::scrape(const lt::torrent_handle& handle, const std::string& url) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_scraped.count(handle)) {
+        return;
+    }
+    if (!url.empty()) {
+        m_hosts[std::string(TrackerList::hostOf(url))].scrapes.push_back(handle);
+    } else {
+        auto it = m_waiting.find(handle);
+        if (it == m_waiting.end()) {
+            return;     // no trackers at all
+        }
+        it->second.scrape = true;
+    }
+    m_scraped.insert(handle);
+}
+
+std::vector<lt::announce_entry> AnnounceScheduler::waiting(const lt::torrent_handle& handle) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_waiting.find(handle);
+    return it != m_waiting.end() ? it->second.trackers : std::vector<lt::announce_entry>();
+}
+
+void AnnounceScheduler::release(std::chrono::steady_clock::time_point now) {
+    std::vector<std::pair<lt::torrent_handle, lt::announce_entry>> due;
+    // Torrents whose current tier left the queues; their next one goes in
+    // line once the loop no longer walks m_hosts
+    std::vector<lt::torrent_handle> advance;
+    std::vector<lt::torrent_handle> scrapes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        unpark(now);
+        
+        const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / ANNOUNCES_PER_SECOND));
+
+        for (auto it = m_hosts.begin(); it != m_hosts.end(); ) {
+            HostQueue& queue = it->second;
+
+            // Catch up on the slots since the last call, but never by more
+            // than a short burst
+            auto slot = std::max(queue.nextAnnounce, now - interval * MAX_BURST);
+            while (!queue.requests.empty() && slot <= now) {
+                Request& request = queue.requests.front();
+                if (isWaiting(request)) {
+                    Pending& pending = m_waiting[request.handle];
+                    pending.inLine--;
+                    if (pending.inLine == 0) {
+                        advance.push_back(request.handle);
+                    }
+                    if (m_hold && m_hold(request.url)) {
+                        m_parked[request.url].push_back(std::move(request));
+                    } else {
+                        if (pending.scrape) {
+                            queue.scrapes.push_back(request.handle);
+                            pending.scrape = false;
+                        }
+                        due.emplace_back(request.handle, takeWaiting(pending, request.url));
+                        slot += jitteredInterval();
+                    }
+                }
+                // else the torrent was removed meanwhile
+                queue.requests.pop_front();
+            }
+            queue.nextAnnounce = slot;
+
+            if (!queue.scrapes.empty() && queue.nextScrape <= now) {
+                size_t n = 0;
+                while (!queue.scrapes.empty() && n < SCRAPE_BATCH) {
+                    if (m_scraped.count(queue.scrapes.front())) {
+                        scrapes.push_back(queue.scrapes.front());
+                        n++;
+                    }
+                    queue.scrapes.pop_front();
+                }
+                queue.nextScrape = now + SCRAPE_INTERVAL;
+            }
+
+            // Drop idle hosts once their pacing no longer matters
+            if (queue.requests.empty() && queue.scrapes.empty()
+                && queue.nextAnnounce < now && queue.nextScrape < now) {
+                it = m_hosts.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (const lt::torrent_handle& handle : advance) {
+            auto it = m_waiting.find(handle);
+            if (it == m_waiting.end()) continue;
+            queueNextTier(handle, it->second);
+            if (it->second.trackers.empty()) {
+                m_waiting.erase(it);
+            }
+        }
+    }
+
+    // add_tracker() only posts to libtorrent's network thread, but there is
+    // no reason to make schedule() wait on it
+    for (const auto& [handle, tracker] : due) {
+        if (handle.is_valid()) {
+            handle.add_tracker(tracker);
+        }
+    }
+    // Attached in tier order, so the default index, the last tracker that
+    // worked or else the first, is the one queued under
+    for (const lt::torrent_handle& handle : scrapes) {
+        if (handle.is_valid()) {
+            handle.scrape_tracker();
+        }
+    }
+}
+
+std::vector<AnnounceScheduler::QueueDepth> AnnounceScheduler::getQueueDepths() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<std::string, QueueDepth> byHost;
+    for (const auto& [host, queue] : m_hosts) {
+        if (queue.requests.empty() && queue.scrapes.empty()) continue;
+        byHost[host] = QueueDepth{host, queue.requests.size(), 0, queue.scrapes.size()};
+    }
+    for (const auto& [url, requests] : m_parked) {
+        std::string host(TrackerList::hostOf(url));
+        QueueDepth& depth = byHost[host];
+        depth.host = host;
+        depth.held += requests.size();
+    }
+    std::vector<QueueDepth> depths;
+    depths.reserve(byHost.size());
+    for (auto& [host, depth] : byHost) {
+        depths.push_back(std::move(depth));
+    }
+    std::sort(depths.begin(), depths.end(), [](const QueueDepth& a, const QueueDepth& b) {
+        return a.trackers + a.held + a.scrapes > b.trackers + b.held + b.scrapes;
+    });
+    return depths;
+}
+
+bool AnnounceScheduler::isWaiting(const Request& request) const {
+    // Caller holds m_mutex
+    auto it = m_waiting.find(request.handle);
+    return it != m_waiting.end() && std::any_of(it->second.trackers.begin(), it->second.trackers.end(),
+        [&](const lt::announce_entry& ae) { return ae.url == request.url; });
+}
+
+lt::announce_entry AnnounceScheduler::takeWaiting(Pending& pending, const std::string& url) {
+    // Caller holds m_mutex and has checked isWaiting()
+    auto t = std::find_if(pending.trackers.begin(), pending.trackers.end(), [&](const lt::announce_entry& ae) {
+        return ae.url == url;
+    });
+    lt::announce_entry tracker = std::move(*t);
+    pending.trackers.erase(t);
+    return tracker;
+}
+
+void AnnounceScheduler::queueNextTier(const lt::torrent_handle& handle, Pending& pending) {
+    // Caller holds m_mutex
+    int next = -1;
+    for (const auto& ae : pending.trackers) {
+        if (ae.tier > pending.tier && (next < 0 || ae.tier < next)) {
+            next = ae.tier;
+        }
+    }
+    if (next < 0) {
+        return;
+    }
+    for (const auto& ae : pending.trackers) {
+        if (ae.tier == next) {
+            m_hosts[std::string(TrackerList::hostOf(ae.url))].requests.push_back(Request{handle, ae.url});
+            pending.inLine++;
+        }
+    }
+    pending.tier = next;
+}
+
+void AnnounceScheduler::unpark(std::chrono::steady_clock::time_point now) {
+    // Caller holds m_mutex
+    if (m_parked.empty() || now < m_nextParkCheck) {
+        return;
+    }
+    m_nextParkCheck = now + PARK_CHECK_INTERVAL;
+    
+    for (auto it = m_parked.begin(); it != m_parked.end(); ) {
+        if (m_hold && m_hold(it->first)) {
+            ++it;
+            continue;
+        }
+        // Back in line behind whatever the host has queued
+        HostQueue& queue = m_hosts[std::string(TrackerList::hostOf(it->first))];
+        for (Request& request : it->second) {
+            if (isWaiting(request)) {
+                m_waiting[request.handle].inLine++;
+                queue.requests.push_back(std::move(request));
+            }
+        }
+        it = m_parked.erase(it);
+    }
+}
+
+std::chrono::steady_clock::duration AnnounceScheduler::jitteredInterval() {
+    // Caller holds m_mutex
+    std::uniform_real_distribution<double> factor(0.5, 1.5);
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(factor(m_random) / ANNOUNCES_PER_SECOND));
+}
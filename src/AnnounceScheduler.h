@@ -0,0 +1,140 @@
+#ifndef ANNOUNCESCHEDULER_H
+#define ANNOUNCESCHEDULER_H
+
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/announce_entry.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <functional>
+
+namespace lt = libtorrent;
+
+/**
+ * @brief Spreads tracker traffic out per tracker host
+ *
+ * Torrents start as soon as they are added (DHT, local discovery and peers
+ * from resume data need no tracker), but their trackers are taken out of
+ * the add_torrent_params and attached later through here. libtorrent
+ * announces to a tracker as soon as it is added to a running torrent, so
+ * attaching it is what sends the first announce.
+ *
+ * A torrent's trackers are queued one tier at a time, each in the queue of
+ * its own host: the next tier goes in line only once every tracker of the
+ * current one has been attached or parked, so libtorrent always has the
+ * torrent's first tier before any fallback. Queues are released at
+ * ANNOUNCES_PER_SECOND with +/-50% jitter (bursts of at most MAX_BURST
+ * after an idle spell), so a restart with thousands of torrents reaches
+ * each tracker as a trickle. libtorrent times the later announces from the
+ * first one, so they stay spread out as well.
+ *
+ * Trackers the hold predicate rejects when their turn comes (demoted ones)
+ * are parked, still counted as waiting, and queued again once it accepts
+ * them. Meanwhile the torrent's next tier moves up, as libtorrent would
+ * fail over to it.
+ *
+ * Torrents libtorrent keeps queued (paused and auto-managed) never
+ * announce, yet it ranks them by swarm size, so each gets one scrape of its
+ * first attached tracker. Scrapes wait in their host's queue apart from the
+ * announces and go out SCRAPE_BATCH at a time every SCRAPE_INTERVAL. For a
+ * UDP tracker libtorrent reuses one connection id across the batch, so
+ * thousands of queued torrents after a restart cost a few connect
+ * handshakes instead of one each.
+ *
+ * Thread-safe: stash() is called from the resume loader's workers, the
+ * rest from the engine thread, getQueueDepths() from any thread.
+ */
+class AnnounceScheduler {
+public:
+    struct QueueDepth {
+        std::string host;
+        size_t trackers;    // waiting to be attached
+        size_t held;        // parked by the hold predicate
+        size_t scrapes;
+    };
+
+    AnnounceScheduler();
+
+    // Returns true for tracker URLs that should not be attached for now
+    void setHold(std::function<bool(const std::string& url)> hold);
+
+    // Trackers taken out of a torrent's add_torrent_params, kept until the
+    // torrent exists
+    void stash(const lt::sha1_hash& key, std::vector<lt::announce_entry> trackers);
+    // The torrent was added: queues its stashed trackers, and returns them
+    std::vector<lt::announce_entry> schedule(const lt::torrent_handle& handle, const lt::sha1_hash& key);
+    // The add failed
+    void dropStash(const lt::sha1_hash& key);
+    // The torrent was removed; its queued trackers are skipped when they
+    // come up
+    void forget(const lt::torrent_handle& handle);
+
+    // Scrapes the torrent once, through the queue of url's host; with an
+    // empty url (no tracker attached yet), through the first one attached
+    void scrape(const lt::torrent_handle& handle, const std::string& url);
+
+    // Trackers of this torrent not attached yet, so resume data keeps them
+    std::vector<lt::announce_entry> waiting(const lt::torrent_handle& handle) const;
+
+    // Attaches whatever is due; call periodically from the engine thread
+    void release(std::chrono::steady_clock::time_point now);
+
+    std::vector<QueueDepth> getQueueDepths() const;
+
+private:
+    struct Request {
+        lt::torrent_handle handle;
+        std::string url;
+    };
+
+    struct HostQueue {
+        std::deque<Request> requests;
+        std::chrono::steady_clock::time_point nextAnnounce;
+        std::deque<lt::torrent_handle> scrapes;
+        std::chrono::steady_clock::time_point nextScrape;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, HostQueue> m_hosts;
+    // Held requests by tracker URL, retried every PARK_CHECK_INTERVAL
+    std::unordered_map<std::string, std::vector<Request>> m_parked;
+    std::chrono::steady_clock::time_point m_nextParkCheck;
+    std::function<bool(const std::string&)> m_hold;
+    struct Pending {
+        std::vector<lt::announce_entry> trackers;   // not attached yet
+        int tier = -1;          // highest tier queued so far
+        size_t inLine = 0;      // requests of this torrent in a host queue
+        bool scrape = false;    // scrape once the first tracker is attached
+    };
+
+    // Per torrent, the trackers not attached yet. A request whose tracker
+    // is no longer listed here (torrent removed) is dropped when it comes up.
+    std::map<lt::torrent_handle, Pending> m_waiting;
+    std::map<lt::sha1_hash, std::vector<lt::announce_entry>> m_stash;
+    // Torrents whose scrape is queued or done. A queued scrape of a torrent
+    // no longer listed here (removed) is dropped when it comes up.
+    std::set<lt::torrent_handle> m_scraped;
+    std::minstd_rand m_random;
+
+    static constexpr double ANNOUNCES_PER_SECOND = 10.0;    // per tracker host
+    static constexpr int MAX_BURST = 5;
+    static constexpr std::chrono::seconds PARK_CHECK_INTERVAL{30};
+    static constexpr size_t SCRAPE_BATCH = 50;             // per tracker host
+    static constexpr std::chrono::seconds SCRAPE_INTERVAL{2};
+
+    // Caller holds m_mutex
+    bool isWaiting(const Request& request) const;
+    lt::announce_entry takeWaiting(Pending& pending, const std::string& url);
+    // Queues the trackers of the lowest tier not queued yet, if any
+    void queueNextTier(const lt::torrent_handle& handle, Pending& pending);
+    void unpark(std::chrono::steady_clock::time_point now);
+    std::chrono::steady_clock::duration jitteredInterval();
+};
+
+#endif // ANNOUNCESCHEDULER_H
@@ -4,19 +4,13 @@
 #include <FL/Fl_File_Chooser.H>
 #include <FL/fl_ask.H>
 #include "PathUtils.h"
-#include <libtorrent/create_torrent.hpp>
-#include <libtorrent/torrent_info.hpp>
-#include <libtorrent/bencode.hpp>
-#include <libtorrent/file_storage.hpp>
 #include <fstream>
-#include <thread>
 #include <iostream>
 #include <unordered_set>
 #include <sstream>
 #include <algorithm>
-#include <filesystem>
-
-namespace lt = libtorrent;
+#include <thread>
+#include <chrono>
 
 CreateTorrentDialog::CreateTorrentDialog()
     : Fl_Window(500, 850, "Create Torrent")
@@ -95,9 +89,15 @@ CreateTorrentDialog::CreateTorrentDialog()
     createUI();
     end();
     set_modal();
+    callback(onClose, this);
 }
 
 CreateTorrentDialog::~CreateTorrentDialog() {
+    Fl::remove_timeout(onProgressTimer, this);
+    // m_creator's destructor cancels and joins a job still running
+    if (m_scan) {
+        m_scan->dialog = nullptr;
+    }
 }
 
 void CreateTorrentDialog::createUI() {
@@ -114,6 +114,8 @@ void CreateTorrentDialog::createUI() {
     
     m_btnSelectFile->callback(onSelectFile, this);
     m_btnSelectFolder->callback(onSelectFolder, this);
+    m_sourcePath->callback(onPlanChanged, this);
+    m_sourcePath->when(FL_WHEN_RELEASE | FL_WHEN_ENTER_KEY);
     y += 50;
 
     // Settings
@@ -132,8 +134,26 @@ void CreateTorrentDialog::createUI() {
     m_pieceSize->add("1 MiB");
     m_pieceSize->add("2 MiB");
     m_pieceSize->add("4 MiB");
+    m_pieceSize->add("8 MiB");
+    m_pieceSize->add("16 MiB");
+    m_pieceSize->add("32 MiB");
+    m_pieceSize->add("64 MiB");
     m_pieceSize->value(0);
-    y += 40;
+    m_pieceSize->callback(onPlanChanged, this);
+
+    // Menu order matches TorrentCreator::Format
+    m_format = new Fl_Choice(340, y, 140, 25, "Format:");
+    m_format->add("Hybrid (v1 + v2)");
+    m_format->add("v1 only");
+    m_format->add("v2 only");
+    m_format->value(0);
+    m_format->callback(onFormatChanged, this);
+    y += 30;
+
+    m_pieceInfo = new Fl_Box(20, y, 460, 20);
+    m_pieceInfo->align(FL_ALIGN_LEFT | FL_ALIGN_INSIDE);
+    m_pieceInfo->labelsize(11);
+    y += 30;
 
     m_isPrivate = new Fl_Check_Button(20, y, 200, 25, "Private (no DHT/LSD)");
     y += 30;
@@ -142,6 +162,8 @@ void CreateTorrentDialog::createUI() {
     y += 30;
     m_optimizeAlignment = new Fl_Check_Button(20, y, 200, 25, "Optimize alignment");
     m_optimizeAlignment->value(1);
+    m_optimizeAlignment->callback(onPlanChanged, this);
+    onFormatChanged(m_format, this);
     y += 40;
 
     // Trackers
@@ -203,12 +225,18 @@ bool CreateTorrentDialog::show_modal() {
 
 void CreateTorrentDialog::onSelectFile(Fl_Widget* w, void* data) {
     const char* f = PathUtils::showFileChooser("Select File", "*", nullptr, Fl_File_Chooser::SINGLE);
-    if (f) ((CreateTorrentDialog*)data)->m_sourcePath->value(f);
+    if (f) {
+        ((CreateTorrentDialog*)data)->m_sourcePath->value(f);
+        ((CreateTorrentDialog*)data)->updatePieceInfo();
+    }
 }
 
 void CreateTorrentDialog::onSelectFolder(Fl_Widget* w, void* data) {
     const char* d = PathUtils::showDirChooser("Select Folder", nullptr);
-    if (d) ((CreateTorrentDialog*)data)->m_sourcePath->value(d);
+    if (d) {
+        ((CreateTorrentDialog*)data)->m_sourcePath->value(d);
+        ((CreateTorrentDialog*)data)->updatePieceInfo();
+    }
 }
 
 void CreateTorrentDialog::onCreate(Fl_Widget* w, void* data) {
@@ -216,7 +244,123 @@ void CreateTorrentDialog::onCreate(Fl_Widget* w, void* data) {
 }
 
 void CreateTorrentDialog::onCancel(Fl_Widget* w, void* data) {
-    ((CreateTorrentDialog*)data)->hide();
+    CreateTorrentDialog* dlg = (CreateTorrentDialog*)data;
+    if (dlg->m_creator && dlg->m_creator->isRunning()) {
+        // The progress timer notices the job ending and resets the dialog
+        dlg->m_creator->cancel();
+        dlg->m_btnCancel->deactivate();
+        return;
+    }
+    dlg->hide();
+}
+
+void CreateTorrentDialog::onClose(Fl_Widget* w, void* data) {
+    CreateTorrentDialog* dlg = (CreateTorrentDialog*)data;
+    if (dlg->m_creator && dlg->m_creator->isRunning()) {
+        dlg->m_creator->cancel();
+        dlg->m_creator->wait();
+        Fl::remove_timeout(onProgressTimer, dlg);
+    }
+    dlg->hide();
+}
+
+void CreateTorrentDialog::onProgressTimer(void* data) {
+    CreateTorrentDialog* dlg = (CreateTorrentDialog*)data;
+    if (!dlg->m_creator) return;
+    
+    if (dlg->m_creator->isRunning()) {
+        TorrentCreator::Progress p = dlg->m_creator->getProgress();
+        if (p.totalBytes > 0) {
+            dlg->m_progress->value(static_cast<float>(p.bytesDone * 100.0 / p.totalBytes));
+        }
+        dlg->m_progress->copy_label(TorrentCreator::formatProgress(p).c_str());
+        Fl::repeat_timeout(PROGRESS_INTERVAL, onProgressTimer, data);
+        return;
+    }
+    dlg->finishCreate();
+}
+
+void CreateTorrentDialog::onFormatChanged(Fl_Widget* w, void* data) {
+    CreateTorrentDialog* dlg = (CreateTorrentDialog*)data;
+    // v2 needs piece-aligned files, so alignment is only a choice for v1
+    if (dlg->m_format->value() == static_cast<int>(TorrentCreator::Format::V1Only)) {
+        dlg->m_optimizeAlignment->activate();
+    } else {
+        dlg->m_optimizeAlignment->value(1);
+        dlg->m_optimizeAlignment->deactivate();
+    }
+    dlg->updatePieceInfo();
+}
+
+void CreateTorrentDialog::onPlanChanged(Fl_Widget* w, void* data) {
+    ((CreateTorrentDialog*)data)->updatePieceInfo();
+}
+
+int CreateTorrentDialog::selectedPieceSize() const {
+    int choice = m_pieceSize->value();
+    return choice > 0 ? PiecePlanner::MIN_PIECE_SIZE << (choice - 1) : 0;
+}
+
+void CreateTorrentDialog::updatePieceInfo() {
+    std::string source = m_sourcePath->value();
+    if (source != m_layoutSource) {
+        m_layout = PiecePlanner::Layout();
+        m_layoutSource = source;
+        if (m_scan) {
+            m_scan->dialog = nullptr;
+            m_scan.reset();
+        }
+        if (!source.empty()) {
+            startScan(source);
+        }
+    }
+    if (m_scan) {
+        // onScanDone() comes back here with the layout
+        m_pieceInfo->copy_label("Scanning...");
+        return;
+    }
+    if (m_layout.fileSizes.empty()) {
+        m_pieceInfo->copy_label("");
+        return;
+    }
+
+    auto format = static_cast<TorrentCreator::Format>(m_format->value());
+    bool aligned = m_optimizeAlignment->value() != 0;
+    int pieceSize = selectedPieceSize();
+    PiecePlanner::Plan plan = pieceSize > 0
+        ? PiecePlanner::estimate(m_layout, pieceSize, format, aligned)
+        : PiecePlanner::choose(m_layout, format, aligned);
+    std::string text = (pieceSize > 0 ? "" : "Auto: ") + PiecePlanner::describe(plan);
+    m_pieceInfo->copy_label(text.c_str());
+}
+
+void CreateTorrentDialog::startScan(const std::string& source) {
+    auto scan = std::make_shared<LayoutScan>();
+    scan->source = source;
+    scan->dialog = this;
+    m_scan = scan;
+
+    std::thread([scan]() {
+        scan->layout = PiecePlanner::scan(scan->source);
+        auto* ref = new std::shared_ptr<LayoutScan>(scan);
+        // There is no later result to carry this one, so wait out a full
+        // awake queue rather than drop it
+        while (Fl::awake(onScanDone, ref) != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }).detach();
+}
+
+void CreateTorrentDialog::onScanDone(void* data) {
+    std::unique_ptr<std::shared_ptr<LayoutScan>> ref((std::shared_ptr<LayoutScan>*)data);
+    LayoutScan& scan = **ref;
+    CreateTorrentDialog* dlg = scan.dialog;
+    if (!dlg || dlg->m_scan.get() != &scan) {
+        return;
+    }
+    dlg->m_layout = std::move(scan.layout);
+    dlg->m_scan.reset();
+    dlg->updatePieceInfo();
 }
 
 void CreateTorrentDialog::onAddGenericTrackers(Fl_Widget* w, void* data) {
@@ -266,6 +410,21 @@ void CreateTorrentDialog::onAddGenericTrackers(Fl_Widget* w, void* data) {
     dlg->m_trackers->value((currentText + toAdd).c_str());
 }
 
+void CreateTorrentDialog::setControlsActive(bool active) {
+    if (active) {
+        m_btnCreate->activate();
+        m_sourcePath->activate();
+        m_btnSelectFile->activate();
+        m_btnSelectFolder->activate();
+    } else {
+        m_btnCreate->deactivate();
+        m_sourcePath->deactivate();
+        m_btnSelectFile->deactivate();
+        m_btnSelectFolder->deactivate();
+    }
+    m_btnCancel->activate();
+}
+
 void CreateTorrentDialog::processCreate() {
     std::string source = m_sourcePath->value();
     if (source.empty()) {
@@ -276,104 +435,58 @@ void CreateTorrentDialog::processCreate() {
     const char* saveFile = PathUtils::showFileChooser("Save Torrent As", "Torrent Files (*.torrent)", "new_torrent.torrent", Fl_File_Chooser::CREATE);
     if (!saveFile) return;
 
-    std::string savePath = saveFile;
-    m_btnCreate->deactivate();
-    m_btnCancel->deactivate();
-
-    // Hashing process in a basic way for now
-    // In a real app, this should be in a thread with UI updates
-    try {
-        lt::file_storage fs;
-        lt::add_files(fs, source);
-
-        int pieceSize = 0;
-        int choice = m_pieceSize->value();
-        if (choice > 0) pieceSize = (16 * 1024) << (choice - 1);
-
-        lt::create_flags_t flags = {};
-        // optimize_alignment is deprecated or removed in newer libtorrent versions.
-        // canonical_files is the modern equivalent for aligning and ordering files.
-        if (m_optimizeAlignment->value()) flags |= lt::create_torrent::canonical_files;
-
-        lt::create_torrent ct(fs, pieceSize, flags);
-        
-        // Add trackers
-        std::stringstream ss(m_trackers->value());
-        std::string line;
-        while (std::getline(ss, line)) {
-            if (!line.empty()) ct.add_tracker(line);
-        }
-        
-        // Add Web Seeds
-        std::stringstream ssWeb(m_webSeeds->value());
-        while (std::getline(ssWeb, line)) {
-            if (!line.empty()) ct.add_url_seed(line);
-        }
+    TorrentCreator::Options options;
+    options.source = source;
+    options.pieceSize = selectedPieceSize();
+    // optimize_alignment is deprecated or removed in newer libtorrent versions.
+    // canonical_files is the modern equivalent for aligning and ordering files.
+    options.format = static_cast<TorrentCreator::Format>(m_format->value());
+    options.canonicalFiles = m_optimizeAlignment->value() != 0;
+    options.isPrivate = m_isPrivate->value() != 0;
+    options.comment = m_comment->value();
+    options.origin = m_origin->value();
+    
+    std::stringstream ss(m_trackers->value());
+    std::string line;
+    while (std::getline(ss, line)) {
+        if (!line.empty()) options.trackers.push_back(line);
+    }
+    std::stringstream ssWeb(m_webSeeds->value());
+    while (std::getline(ssWeb, line)) {
+        if (!line.empty()) options.webSeeds.push_back(line);
+    }
 
-        if (m_isPrivate->value()) ct.set_priv(true);
-        ct.set_comment(m_comment->value());
-        ct.set_creator("fTorrent");
-
-        // Hash pieces
-        m_progress->label("Hashing pieces...");
-        Fl::check();
-        
-        // On Windows, libtorrent's set_piece_hashes needs the parent directory 
-        // because add_files adds files with the source directory name as a prefix.
-        // We use std::filesystem to get the parent path safely.
-#if defined(__cpp_lib_char8_t)
-        std::filesystem::path sourcePath(std::u8string_view((const char8_t*)source.c_str(), source.length()));
-#else
-        std::filesystem::path sourcePath = std::filesystem::u8path(source);
-#endif
-        std::filesystem::path parent = sourcePath.parent_path();
-        
-        std::string parentPathStr;
-#if defined(__cpp_lib_char8_t)
-        std::u8string u8Parent = parent.u8string();
-        parentPathStr.assign((const char*)u8Parent.data(), u8Parent.size());
-#else
-        parentPathStr = parent.u8string();
-#endif
-        if (parentPathStr.empty()) parentPathStr = ".";
-
-        lt::error_code ec;
-        lt::set_piece_hashes(ct, parentPathStr, [this](lt::piece_index_t p) {
-            // Update progress if we were in a thread, but here we just keep it blocking
-        }, ec);
-
-        if (ec) {
-            throw std::system_error(ec.value(), std::generic_category(), ec.message());
-        }
+    if (!m_creator) {
+        m_creator = std::make_unique<TorrentCreator>();
+    }
+    if (!m_creator->start(options, saveFile)) {
+        return;
+    }
 
-        lt::entry e = ct.generate();
-        if (strlen(m_origin->value()) > 0) e["source"] = m_origin->value();
-
-        std::vector<char> torrent;
-        lt::bencode(std::back_inserter(torrent), e);
-
-        // Use std::filesystem::path to handle UTF-8 paths on Windows correctly
-        std::filesystem::path pSave;
-#if defined(__cpp_lib_char8_t)
-        pSave = std::filesystem::path(std::u8string_view((const char8_t*)savePath.c_str(), savePath.length()));
-#else
-        pSave = std::filesystem::u8path(savePath);
-#endif
-        std::ofstream out(pSave, std::ios_base::binary);
-        if (!out) {
-            fl_alert("Could not open file for writing: %s", savePath.c_str());
-            return;
-        }
-        out.write(torrent.data(), torrent.size());
-        out.close();
+    setControlsActive(false);
+    m_progress->value(0);
+    m_progress->copy_label("Hashing pieces...");
+    Fl::add_timeout(PROGRESS_INTERVAL, onProgressTimer, this);
+}
 
+void CreateTorrentDialog::finishCreate() {
+    m_creator->wait();
+    
+    if (m_creator->succeeded()) {
+        m_progress->value(100);
+        m_progress->copy_label("Done");
         fl_message("Torrent created successfully!");
         m_okClicked = true;
         hide();
+        return;
+    }
 
-    } catch (const std::exception& e) {
-        fl_alert("Error creating torrent: %s", e.what());
-        m_btnCreate->activate();
-        m_btnCancel->activate();
+    m_progress->value(0);
+    if (m_creator->wasCancelled()) {
+        m_progress->copy_label("Cancelled");
+    } else {
+        m_progress->copy_label("");
+        fl_alert("Error creating torrent: %s", m_creator->getError().c_str());
     }
+    setControlsActive(true);
 }
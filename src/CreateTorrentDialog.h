@@ -8,8 +8,12 @@
 #include <FL/Fl_Check_Button.H>
 #include <FL/Fl_Choice.H>
 #include <FL/Fl_Progress.H>
+#include <FL/Fl_Box.H>
 #include <string>
 #include <vector>
+#include <memory>
+#include "TorrentCreator.h"
+#include "PiecePlanner.h"
 
 class CreateTorrentDialog : public Fl_Window {
 public:
@@ -25,6 +29,8 @@ private:
     Fl_Button* m_btnSelectFolder;
     
     Fl_Choice* m_pieceSize;
+    Fl_Choice* m_format;
+    Fl_Box* m_pieceInfo;
     Fl_Multiline_Input* m_trackers;
     Fl_Button* m_btnAddGenericTrackers;
     Fl_Multiline_Input* m_webSeeds;
@@ -41,6 +47,23 @@ private:
 
     bool m_okClicked;
 
+    // File layout of the current source, rescanned only when it changes.
+    // The walk runs on a worker thread (a large tree takes seconds) and the
+    // result comes back through Fl::awake; only the latest scan is applied,
+    // and one that outlives the dialog is dropped.
+    struct LayoutScan {
+        std::string source;
+        PiecePlanner::Layout layout;
+        CreateTorrentDialog* dialog = nullptr; // UI thread only; null once superseded
+    };
+    PiecePlanner::Layout m_layout;
+    std::string m_layoutSource;
+    std::shared_ptr<LayoutScan> m_scan;    // in flight, or null
+    
+    // Hashing runs on the creator's threads; a timer polls its progress
+    std::unique_ptr<TorrentCreator> m_creator;
+    static constexpr double PROGRESS_INTERVAL = 0.2;
+
     // UI creation
     void createUI();
     void createButtons();
@@ -51,8 +74,18 @@ private:
     static void onCreate(Fl_Widget* w, void* data);
     static void onCancel(Fl_Widget* w, void* data);
     static void onAddGenericTrackers(Fl_Widget* w, void* data);
+    static void onFormatChanged(Fl_Widget* w, void* data);
+    static void onPlanChanged(Fl_Widget* w, void* data);
+    static void onClose(Fl_Widget* w, void* data);
+    static void onProgressTimer(void* data);
+    static void onScanDone(void* data);
 
     void processCreate();
+    void finishCreate();
+    void setControlsActive(bool active);
+    int selectedPieceSize() const;
+    void updatePieceInfo();
+    void startScan(const std::string& source);
 };
 
 #endif // CREATETORRENTDIALOG_H
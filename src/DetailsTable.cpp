@@ -0,0 +1,102 @@
+#include "DetailsTable.h"
+#include <FL/fl_draw.H>
+#include <FL/Fl.H>
+
+DetailsTable::DetailsTable(int x, int y, int w, int h, const std::vector<Column>& columns)
+    : Fl_Table_Row(x, y, w, h)
+    , m_columns(columns)
+{
+    cols(static_cast<int>(m_columns.size()));
+    col_header(1);
+    col_resize(1);
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        col_width(static_cast<int>(i), m_columns[i].width);
+    }
+    row_height_all(20);
+    row_header(0);
+    rows(0);
+
+    type(SELECT_SINGLE);
+    vscrollbar->box(FL_FLAT_BOX);
+    hscrollbar->box(FL_FLAT_BOX);
+
+    end();
+}
+
+void DetailsTable::setRowCount(int n) {
+    if (n == rows()) {
+        return;
+    }
+    m_cells.resize(static_cast<size_t>(n) * m_columns.size());
+    rows(n);
+    redraw();
+}
+
+void DetailsTable::setCell(int row, int col, std::string_view text) {
+    if (row < 0 || row >= rows() || col < 0 || col >= cols()) {
+        return;
+    }
+    std::string& cell = m_cells[static_cast<size_t>(row) * m_columns.size() + col];
+    if (cell == text) {
+        return;
+    }
+    cell.assign(text.data(), text.size());
+
+    int top, bottom, left, right;
+    visible_cells(top, bottom, left, right);
+    if (row >= top && row <= bottom && col >= left && col <= right) {
+        redraw_range(row, row, col, col);
+    }
+}
+
+void DetailsTable::draw_cell(TableContext context, int row, int col,
+                             int x, int y, int w, int h)
+{
+    if (col < 0 || col >= static_cast<int>(m_columns.size())) {
+        return;
+    }
+
+    switch (context) {
+        case CONTEXT_COL_HEADER:
+            fl_push_clip(x, y, w, h);
+            fl_draw_box(FL_THIN_UP_BOX, x, y, w, h, FL_LIGHT2);
+            fl_color(FL_FOREGROUND_COLOR);
+            fl_font(FL_HELVETICA_BOLD, 12);
+            fl_draw(m_columns[col].name, x + 5, y, w - 10, h, m_columns[col].alignment);
+            fl_pop_clip();
+            break;
+
+        case CONTEXT_CELL: {
+            if (row < 0 || row >= rows()) {
+                break;
+            }
+            bool selected = row_selected(row);
+            fl_push_clip(x, y, w, h);
+            fl_color(getRowColor(row));
+            fl_rectf(x, y, w, h);
+            fl_color(selected ? FL_WHITE : FL_FOREGROUND_COLOR);
+            fl_font(FL_HELVETICA, 12);
+            const std::string& text = m_cells[static_cast<size_t>(row) * m_columns.size() + col];
+            fl_draw(text.c_str(), x + 5, y, w - 10, h, m_columns[col].alignment | FL_ALIGN_CLIP);
+            fl_pop_clip();
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+Fl_Color DetailsTable::getRowColor(int row) const {
+    if (const_cast<DetailsTable*>(this)->row_selected(row)) return FL_SELECTION_COLOR;
+    if (row % 2 == 0) return FL_BACKGROUND2_COLOR;
+
+    // Same striping as the torrent list
+    uchar r, g, b;
+    Fl::get_color(FL_BACKGROUND2_COLOR, r, g, b);
+    if (r > 128) {
+        return fl_rgb_color(r - 10, g - 10, b - 10);
+    } else {
+        return fl_rgb_color(r + 10, g + 10, b + 10);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef DETAILSTABLE_H
+#define DETAILSTABLE_H
+
+#include <FL/Fl_Table_Row.H>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Read-only text table for the torrent details tabs
+ *
+ * Holds the formatted text of every cell, but like any Fl_Table only draws
+ * the rows on screen, so a 40,000-file torrent costs no more to show than
+ * a small one. setCell() ignores text that did not change and redraws just
+ * the cell otherwise, and only when it is visible.
+ */
+class DetailsTable : public Fl_Table_Row {
+public:
+    struct Column {
+        const char* name;
+        int width;
+        Fl_Align alignment;
+    };
+
+    DetailsTable(int x, int y, int w, int h, const std::vector<Column>& columns);
+
+    // Grows or shrinks to n rows; the text of the remaining rows is kept
+    void setRowCount(int n);
+    void setCell(int row, int col, std::string_view text);
+
+protected:
+    void draw_cell(TableContext context, int row, int col,
+                   int x, int y, int w, int h) override;
+
+private:
+    std::vector<Column> m_columns;
+    std::vector<std::string> m_cells;   // row-major
+
+    Fl_Color getRowColor(int row) const;
+};
+
+#endif // DETAILSTABLE_H
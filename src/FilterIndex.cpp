@@ -0,0 +1,271 @@
+#include "FilterIndex.h"
+#include <algorithm>
+
+void FilterIndex::update(const TorrentSnapshot& snapshot) {
+    // Status ticks that only move numbers leave the labels version alone
+    if (snapshot.labelsVersion == m_labelsVersion) {
+        return;
+    }
+    m_labelsVersion = snapshot.labelsVersion;
+    m_generation++;
+    const TorrentStatusTable::Columns& c = snapshot.columns;
+
+    for (size_t row = 0; row < snapshot.size(); row++) {
+        const TorrentItem::Key& key = snapshot.keys[row];
+        auto it = m_ids.find(key);
+        Id id;
+        // Names are shared between snapshots and only replaced when they
+        // change, so a pointer compare finds renames. A renamed torrent
+        // gets a new id rather than edits to its posting lists.
+        if (it != m_ids.end() && m_entries[it->second].name == c.name[row]) {
+            id = it->second;
+        } else {
+            if (it != m_ids.end()) remove(it->second);
+            id = add(key, c.name[row]);
+        }
+
+        Entry& e = m_entries[id];
+        e.seen = m_generation;
+        if (e.savePath != c.savePath[row]) {
+            setPath(id, c.savePath[row]);
+        }
+        if (e.state != static_cast<int>(c.state[row])) {
+            setState(id, static_cast<int>(c.state[row]));
+        }
+        if (e.tracker != c.trackerHost[row]) {
+            setTracker(id, c.trackerHost[row]);
+        }
+    }
+
+    for (Id id = 0; id < m_entries.size(); id++) {
+        if (m_entries[id].alive && m_entries[id].seen != m_generation) {
+            remove(id);
+        }
+    }
+
+    if (m_dead >= MIN_DEAD_TO_COMPACT && m_dead > m_entries.size() - m_dead) {
+        compact();
+    }
+}
+
+void FilterIndex::clear() {
+    m_entries.clear();
+    m_dead = 0;
+    m_ids.clear();
+    m_labelsVersion = 0;
+    m_byState.clear();
+    m_byTracker.clear();
+    m_byPath.clear();
+    m_postings.clear();
+}
+
+std::vector<char> FilterIndex::match(const TorrentSnapshot& snapshot, const Query& query) const {
+    std::vector<char> mask(snapshot.size(), query.empty() ? 1 : 0);
+    if (query.empty()) {
+        return mask;
+    }
+
+    const std::string needle = lower(query.text);
+
+    // Pick the smallest candidate source; an empty bucket means no matches
+    const std::unordered_set<Id>* bucket = nullptr;
+    if (query.state >= 0) {
+        auto it = m_byState.find(query.state);
+        if (it == m_byState.end() || it->second.empty()) return mask;
+        bucket = &it->second;
+    }
+    if (!query.tracker.empty()) {
+        auto it = m_byTracker.find(query.tracker);
+        if (it == m_byTracker.end() || it->second.empty()) return mask;
+        if (!bucket || it->second.size() < bucket->size()) bucket = &it->second;
+    }
+    // Text matches a name (trigram postings) or a save path (the few
+    // path buckets whose path contains it)
+    const std::vector<Id>* postings = nullptr;
+    bool namesMatch = true;
+    std::vector<const std::unordered_set<Id>*> paths;
+    size_t textCandidates = 0;
+    if (needle.size() >= 3) {
+        std::vector<Trigram> trigrams;
+        trigramsOf(needle, trigrams);
+        for (Trigram t : trigrams) {
+            auto it = m_postings.find(t);
+            if (it == m_postings.end()) {
+                namesMatch = false;
+                postings = nullptr;
+                break;
+            }
+            if (!postings || it->second.size() < postings->size()) postings = &it->second;
+        }
+        for (const auto& [path, ids] : m_byPath) {
+            if (path.find(needle) == std::string::npos) continue;
+            paths.push_back(&ids);
+            textCandidates += ids.size();
+        }
+        if (!namesMatch && paths.empty()) return mask;
+        if (postings) textCandidates += postings->size();
+    }
+
+    auto verify = [&](Id id) {
+        const Entry& e = m_entries[id];
+        if (!e.alive) return;
+        if (query.state >= 0 && e.state != query.state) return;
+        if (!query.tracker.empty() && (!e.tracker || *e.tracker != query.tracker)) return;
+        if (!needle.empty() && e.text.find(needle) == std::string::npos
+            && e.path.find(needle) == std::string::npos) return;
+        int row = snapshot.find(e.key);
+        if (row >= 0) mask[row] = 1;
+    };
+
+    if (needle.size() >= 3 && (!bucket || textCandidates <= bucket->size())) {
+        if (postings) {
+            for (Id id : *postings) verify(id);
+        }
+        for (const auto* ids : paths) {
+            for (Id id : *ids) verify(id);
+        }
+    } else if (bucket) {
+        for (Id id : *bucket) verify(id);
+    } else {
+        // Short text only: nothing narrower than a scan
+        for (Id id = 0; id < m_entries.size(); id++) verify(id);
+    }
+    return mask;
+}
+
+std::vector<std::string> FilterIndex::getTrackerHosts() const {
+    std::vector<std::string> hosts;
+    for (const auto& [host, ids] : m_byTracker) {
+        if (!host.empty() && !ids.empty()) hosts.push_back(host);
+    }
+    std::sort(hosts.begin(), hosts.end());
+    return hosts;
+}
+
+FilterIndex::Id FilterIndex::add(const TorrentItem::Key& key, const std::shared_ptr<const std::string>& name) {
+    Id id = static_cast<Id>(m_entries.size());
+    m_entries.emplace_back();
+    Entry& e = m_entries.back();
+    e.key = key;
+    e.name = name;
+    e.text = name ? lower(*name) : std::string();
+    e.alive = true;
+    m_ids[key] = id;
+
+    // The newest id is the largest, so this appends
+    std::vector<Trigram> trigrams;
+    trigramsOf(e.text, trigrams);
+    for (Trigram t : trigrams) {
+        m_postings[t].push_back(id);
+    }
+    return id;
+}
+
+void FilterIndex::setState(Id id, int state) {
+    Entry& e = m_entries[id];
+    if (e.state >= 0) m_byState[e.state].erase(id);
+    e.state = state;
+    if (state >= 0) m_byState[state].insert(id);
+}
+
+void FilterIndex::setTracker(Id id, const std::shared_ptr<const std::string>& tracker) {
+    Entry& e = m_entries[id];
+    if (e.tracker) {
+        auto it = m_byTracker.find(*e.tracker);
+        if (it != m_byTracker.end()) {
+            it->second.erase(id);
+            if (it->second.empty()) m_byTracker.erase(it);
+        }
+    }
+    e.tracker = tracker;
+    if (tracker) m_byTracker[*tracker].insert(id);
+}
+
+void FilterIndex::setPath(Id id, const std::shared_ptr<const std::string>& savePath) {
+    Entry& e = m_entries[id];
+    if (e.savePath) {
+        auto it = m_byPath.find(e.path);
+        if (it != m_byPath.end()) {
+            it->second.erase(id);
+            if (it->second.empty()) m_byPath.erase(it);
+        }
+    }
+    e.savePath = savePath;
+    e.path = savePath ? lower(*savePath) : std::string();
+    if (savePath) m_byPath[e.path].insert(id);
+}
+
+void FilterIndex::remove(Id id) {
+    // The id stays in its posting lists until compact()
+    setState(id, -1);
+    setTracker(id, nullptr);
+    setPath(id, nullptr);
+    Entry& e = m_entries[id];
+    auto it = m_ids.find(e.key);
+    if (it != m_ids.end() && it->second == id) m_ids.erase(it);
+    e = Entry();
+    m_dead++;
+}
+
+void FilterIndex::compact() {
+    // Live entries keep their relative order, so renumbered posting lists
+    // stay sorted
+    std::vector<Id> newId(m_entries.size(), 0);
+    std::vector<char> live(m_entries.size(), 0);
+    std::vector<Entry> entries;
+    entries.reserve(m_entries.size() - m_dead);
+    for (Id id = 0; id < m_entries.size(); id++) {
+        if (!m_entries[id].alive) continue;
+        live[id] = 1;
+        newId[id] = static_cast<Id>(entries.size());
+        entries.push_back(std::move(m_entries[id]));
+    }
+    m_entries.swap(entries);
+    m_dead = 0;
+
+    for (auto it = m_postings.begin(); it != m_postings.end(); ) {
+        std::vector<Id>& list = it->second;
+        size_t out = 0;
+        for (Id id : list) {
+            if (live[id]) list[out++] = newId[id];
+        }
+        list.resize(out);
+        if (list.empty()) {
+            it = m_postings.erase(it);
+        } else {
+            list.shrink_to_fit();
+            ++it;
+        }
+    }
+
+    m_ids.clear();
+    m_byState.clear();
+    m_byTracker.clear();
+    m_byPath.clear();
+    for (Id id = 0; id < m_entries.size(); id++) {
+        const Entry& e = m_entries[id];
+        m_ids[e.key] = id;
+        if (e.state >= 0) m_byState[e.state].insert(id);
+        if (e.tracker) m_byTracker[*e.tracker].insert(id);
+        if (e.savePath) m_byPath[e.path].insert(id);
+    }
+}
+
+std::string FilterIndex::lower(std::string_view text) {
+    std::string out(text);
+    for (char& ch : out) {
+        if (ch >= 'A' && ch <= 'Z') ch = static_cast<char>(ch - 'A' + 'a');
+    }
+    return out;
+}
+
+void FilterIndex::trigramsOf(const std::string& text, std::vector<Trigram>& out) {
+    out.clear();
+    for (size_t i = 0; i + 3 <= text.size(); i++) {
+        out.push_back((static_cast<Trigram>(static_cast<unsigned char>(text[i])) << 16)
+            | (static_cast<Trigram>(static_cast<unsigned char>(text[i + 1])) << 8)
+            | static_cast<Trigram>(static_cast<unsigned char>(text[i + 2])));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
@@ -0,0 +1,100 @@
+#ifndef FILTERINDEX_H
+#define FILTERINDEX_H
+
+#include "TorrentItem.h"
+#include "TorrentSnapshot.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+
+/**
+ * @brief Incrementally maintained search index over the torrent list
+ *
+ * Keeps, per torrent, which state, tracker-host and save-path bucket it is
+ * in and the trigrams of its lower-cased name. Save paths are few and
+ * shared by many torrents, so they are matched per bucket rather than
+ * given trigrams of their own.
+ *
+ * update() does nothing unless the snapshot's labelsVersion moved; then it
+ * walks the snapshot and only re-indexes torrents whose shared
+ * name/path/tracker strings or state changed (pointer and value compares).
+ *
+ * Posting lists are append-only: a removed or renamed torrent's id is left
+ * in them as a tombstone (skipped by match()) and a new id is handed out,
+ * so removals cost nothing per trigram. Once tombstones outnumber live
+ * entries the lists are compacted in one pass.
+ *
+ * match() starts from the smallest candidate set (state bucket, tracker
+ * bucket, or the shortest trigram posting list plus the matching path
+ * buckets), then verifies each candidate, so narrowing a large list costs
+ * about the size of the answer.
+ */
+class FilterIndex {
+public:
+    struct Query {
+        std::string text;       // substring of name or save path, case-insensitive
+        int state = -1;         // TorrentItem::State, -1 = any
+        std::string tracker;    // tracker host, empty = any
+
+        bool empty() const { return text.empty() && state < 0 && tracker.empty(); }
+    };
+
+    void update(const TorrentSnapshot& snapshot);
+    void clear();
+
+    // Rows of snapshot (the one last passed to update()) that match, as a
+    // per-row mask
+    std::vector<char> match(const TorrentSnapshot& snapshot, const Query& query) const;
+
+    // Tracker hosts seen, sorted, for the filter bar
+    std::vector<std::string> getTrackerHosts() const;
+
+private:
+    using Id = uint32_t;
+    using Trigram = uint32_t;
+
+    struct Entry {
+        TorrentItem::Key key;
+        std::shared_ptr<const std::string> name;
+        std::shared_ptr<const std::string> savePath;
+        std::shared_ptr<const std::string> tracker;
+        std::string text;       // lower-cased name, what trigrams index
+        std::string path;       // lower-cased save path, its m_byPath bucket
+        int state = -1;
+        uint64_t seen = 0;      // update() generation, to find removed torrents
+        bool alive = false;
+    };
+
+    // Ids only grow (until compact()), so posting lists stay sorted by
+    // appending
+    std::vector<Entry> m_entries;
+    size_t m_dead = 0;
+    std::unordered_map<TorrentItem::Key, Id, TorrentItem::KeyHash> m_ids;
+    uint64_t m_generation = 0;
+    uint64_t m_labelsVersion = 0;
+
+    std::unordered_map<int, std::unordered_set<Id>> m_byState;
+    std::unordered_map<std::string, std::unordered_set<Id>> m_byTracker;
+    std::unordered_map<std::string, std::unordered_set<Id>> m_byPath;
+    // Sorted id lists per name trigram, tombstones included
+    std::unordered_map<Trigram, std::vector<Id>> m_postings;
+
+    // Below this many tombstones compaction is not worth a pass
+    static constexpr size_t MIN_DEAD_TO_COMPACT = 1024;
+
+    Id add(const TorrentItem::Key& key, const std::shared_ptr<const std::string>& name);
+    void setState(Id id, int state);
+    void setTracker(Id id, const std::shared_ptr<const std::string>& tracker);
+    void setPath(Id id, const std::shared_ptr<const std::string>& savePath);
+    void remove(Id id);
+    void compact();
+
+    static std::string lower(std::string_view text);
+    static void trigramsOf(const std::string& text, std::vector<Trigram>& out);
+};
+
+#endif // FILTERINDEX_H
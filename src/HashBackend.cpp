@@ -0,0 +1,239 @@
+#include "HashBackend.h"
+#include <libtorrent/hasher.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+
+namespace lt = libtorrent;
+
+// Defined in HashBackendShaNi.cpp
+bool shaNiSupported();
+void sha1CompressShaNi(uint32_t state[5], const uint8_t* data, size_t blocks);
+void sha256CompressShaNi(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+namespace {
+    const uint32_t SHA1_INIT[5] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+    };
+    const uint32_t SHA256_INIT[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    const uint32_t K256[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    inline uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+    inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    inline uint32_t loadBE(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    void sha1CompressScalar(uint32_t state[5], const uint8_t* data, size_t blocks) {
+        uint32_t w[80];
+        for (size_t n = 0; n < blocks; ++n, data += 64) {
+            for (int i = 0; i < 16; ++i) w[i] = loadBE(data + 4 * i);
+            for (int i = 16; i < 80; ++i) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+            for (int i = 0; i < 80; ++i) {
+                uint32_t f, k;
+                if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5a827999; }
+                else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ed9eba1; }
+                else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdc; }
+                else             { f = b ^ c ^ d;                   k = 0xca62c1d6; }
+                uint32_t t = rotl(a, 5) + f + e + k + w[i];
+                e = d; d = c; c = rotl(b, 30); b = a; a = t;
+            }
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+        }
+    }
+
+    void sha256CompressScalar(uint32_t state[8], const uint8_t* data, size_t blocks) {
+        uint32_t w[64];
+        for (size_t n = 0; n < blocks; ++n, data += 64) {
+            for (int i = 0; i < 16; ++i) w[i] = loadBE(data + 4 * i);
+            for (int i = 16; i < 64; ++i) {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i) {
+                uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                uint32_t ch = (e & f) ^ (~e & g);
+                uint32_t t1 = h + s1 + ch + K256[i] + w[i];
+                uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+                uint32_t t2 = s0 + maj;
+                h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+            }
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+    }
+
+    // Merkle-Damgard padding shared by SHA-1 and SHA-256: whole blocks go
+    // straight to the block function, the tail is padded on the stack.
+    template <int WORDS>
+    void digest(const char* data, size_t size, uint8_t* out, const uint32_t (&init)[WORDS],
+                void (*compress)(uint32_t*, const uint8_t*, size_t)) {
+        uint32_t state[WORDS];
+        std::memcpy(state, init, sizeof(state));
+
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        size_t full = size / 64;
+        if (full > 0) {
+            compress(state, bytes, full);
+        }
+
+        uint8_t tail[128] = {};
+        size_t rem = size - full * 64;
+        if (rem > 0) {
+            std::memcpy(tail, bytes + full * 64, rem);
+        }
+        tail[rem] = 0x80;
+        size_t tailBlocks = rem + 9 > 64 ? 2 : 1;
+        uint64_t bits = static_cast<uint64_t>(size) * 8;
+        for (int i = 0; i < 8; ++i) {
+            tail[tailBlocks * 64 - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+        compress(state, tail, tailBlocks);
+
+        for (int i = 0; i < WORDS; ++i) {
+            out[4 * i + 0] = static_cast<uint8_t>(state[i] >> 24);
+            out[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+            out[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+            out[4 * i + 3] = static_cast<uint8_t>(state[i]);
+        }
+    }
+
+    void sha1Scalar(const char* data, size_t size, uint8_t* out) {
+        digest(data, size, out, SHA1_INIT, sha1CompressScalar);
+    }
+    void sha256Scalar(const char* data, size_t size, uint8_t* out) {
+        digest(data, size, out, SHA256_INIT, sha256CompressScalar);
+    }
+    void sha1ShaNi(const char* data, size_t size, uint8_t* out) {
+        digest(data, size, out, SHA1_INIT, sha1CompressShaNi);
+    }
+    void sha256ShaNi(const char* data, size_t size, uint8_t* out) {
+        digest(data, size, out, SHA256_INIT, sha256CompressShaNi);
+    }
+    void sha1Libtorrent(const char* data, size_t size, uint8_t* out) {
+        lt::sha1_hash h = lt::hasher(data, static_cast<int>(size)).final();
+        std::memcpy(out, h.data(), lt::sha1_hash::size());
+    }
+    void sha256Libtorrent(const char* data, size_t size, uint8_t* out) {
+        lt::sha256_hash h = lt::hasher256(data, static_cast<int>(size)).final();
+        std::memcpy(out, h.data(), lt::sha256_hash::size());
+    }
+
+    const HashBackend SHA_NI = { "sha-ni", sha1ShaNi, sha256ShaNi };
+    const HashBackend LIBTORRENT = { "libtorrent", sha1Libtorrent, sha256Libtorrent };
+    const HashBackend SCALAR = { "scalar", sha1Scalar, sha256Scalar };
+
+    double measureGBps(HashBackend::DigestFn fn, const std::vector<char>& buffer, size_t chunk) {
+        uint8_t out[32];
+        size_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        // At least half a second, and at least one pass over the buffer
+        while (seconds < 0.5) {
+            for (size_t off = 0; off + chunk <= buffer.size(); off += chunk) {
+                fn(buffer.data() + off, chunk, out);
+                bytes += chunk;
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return bytes / seconds / 1e9;
+    }
+
+    std::string formatRate(double gbps) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.2f GB/s", gbps);
+        return buf;
+    }
+}
+
+const std::vector<const HashBackend*>& HashBackend::available() {
+    static const std::vector<const HashBackend*> backends = []() {
+        std::vector<const HashBackend*> list;
+        if (shaNiSupported()) list.push_back(&SHA_NI);
+        list.push_back(&LIBTORRENT);
+        list.push_back(&SCALAR);
+        return list;
+    }();
+    return backends;
+}
+
+const HashBackend& HashBackend::best() {
+    return *available().front();
+}
+
+const HashBackend* HashBackend::find(const std::string& name) {
+    if (name.empty() || name == "auto") {
+        return &best();
+    }
+    for (const HashBackend* b : available()) {
+        if (name == b->name) return b;
+    }
+    return nullptr;
+}
+
+int HashBackend::runBenchmark() {
+    // Pseudo-random data so no backend gets an easy ride
+    std::vector<char> buffer(64 * 1024 * 1024);
+    uint32_t x = 0x9e3779b9;
+    for (auto& c : buffer) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        c = static_cast<char>(x);
+    }
+
+    // Every backend must agree with the scalar reference, including the
+    // padding edge cases around the 55/56/64-byte boundaries
+    const size_t sizes[] = { 0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 1000, 16384, 16385, 1 << 20 };
+    bool ok = true;
+    for (const HashBackend* b : available()) {
+        for (size_t size : sizes) {
+            uint8_t expect[32], got[32];
+            SCALAR.sha1(buffer.data(), size, expect);
+            b->sha1(buffer.data(), size, got);
+            bool match = std::memcmp(expect, got, 20) == 0;
+            SCALAR.sha256(buffer.data(), size, expect);
+            b->sha256(buffer.data(), size, got);
+            match = match && std::memcmp(expect, got, 32) == 0;
+            if (!match) {
+                std::cerr << b->name << ": digest mismatch for " << size << " bytes" << std::endl;
+                ok = false;
+            }
+        }
+    }
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "Single-thread hashing throughput (" << buffer.size() / (1024 * 1024)
+              << " MiB buffer, best backend: " << best().name << ")" << std::endl;
+    std::cout << std::left << std::setw(12) << "backend"
+              << std::setw(22) << "SHA-1 (1 MiB pieces)"
+              << "SHA-256 (16 KiB blocks)" << std::endl;
+    for (const HashBackend* b : available()) {
+        double sha1 = measureGBps(b->sha1, buffer, 1024 * 1024);
+        double sha256 = measureGBps(b->sha256, buffer, 16 * 1024);
+        std::cout << std::left << std::setw(12) << b->name
+                  << std::setw(22) << formatRate(sha1) << formatRate(sha256) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef HASHBACKEND_H
+#define HASHBACKEND_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief SHA-1 / SHA-256 implementations used for piece hashing
+ *
+ * Each backend is a pair of one-shot digest functions. The table is
+ * resolved at runtime: "sha-ni" needs the x86 SHA extensions, while
+ * "libtorrent" (lt::hasher, whatever crypto library it was built with)
+ * and "scalar" (portable C++) always work. best() picks the first
+ * backend this CPU supports.
+ */
+struct HashBackend {
+    using DigestFn = void (*)(const char* data, size_t size, uint8_t* out);
+
+    const char* name;
+    DigestFn sha1;      // writes 20 bytes
+    DigestFn sha256;    // writes 32 bytes
+
+    // Backends usable on this machine, preferred first
+    static const std::vector<const HashBackend*>& available();
+    static const HashBackend& best();
+    // "auto" or a backend name; nullptr if unknown or unsupported here
+    static const HashBackend* find(const std::string& name);
+
+    // Checks every backend against the scalar one, then prints single-thread
+    // throughput for each. Returns a process exit code.
+    static int runBenchmark();
+};
+
+#endif // HASHBACKEND_H
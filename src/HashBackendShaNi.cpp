@@ -0,0 +1,194 @@
+// SHA-1 and SHA-256 block functions using the x86 SHA extensions.
+// Compiled with per-function target attributes, so the rest of the
+// program does not require SHA-NI; HashBackend only calls these after
+// shaNiSupported() returned true.
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FTORRENT_HAVE_SHANI 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHANI_TARGET
+#else
+#include <cpuid.h>
+#define SHANI_TARGET __attribute__((target("sha,sse4.1")))
+#endif
+#endif
+
+#ifdef FTORRENT_HAVE_SHANI
+
+namespace {
+    alignas(16) const uint32_t K256[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+}
+
+bool shaNiSupported() {
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    c = static_cast<unsigned int>(regs[2]);
+    __cpuidex(regs, 7, 0);
+    b = static_cast<unsigned int>(regs[1]);
+#else
+    if (__get_cpuid_max(0, nullptr) < 7) return false;
+    __cpuid(1, a, b, c, d);
+    unsigned int c1 = c;
+    __cpuid_count(7, 0, a, b, c, d);
+    c = c1;
+#endif
+    bool sse41 = (c & (1u << 19)) != 0;
+    bool ssse3 = (c & (1u << 9)) != 0;
+    bool sha = (b & (1u << 29)) != 0;
+    return sse41 && ssse3 && sha;
+}
+
+// One group of four rounds. CUR holds this group's message words; NEXT and
+// PREV are advanced by the message schedule while the rounds run.
+#define SHA256_GROUP(I, CUR, NEXT, PREV, MSG2, MSG1)                                   \
+    msg = _mm_add_epi32(CUR, _mm_load_si128(reinterpret_cast<const __m128i*>(&K256[4 * (I)]))); \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                                \
+    if (MSG2) {                                                                         \
+        NEXT = _mm_add_epi32(NEXT, _mm_alignr_epi8(CUR, PREV, 4));                      \
+        NEXT = _mm_sha256msg2_epu32(NEXT, CUR);                                         \
+    }                                                                                   \
+    msg = _mm_shuffle_epi32(msg, 0x0E);                                                 \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                                \
+    if (MSG1) {                                                                         \
+        PREV = _mm_sha256msg1_epu32(PREV, CUR);                                         \
+    }
+
+SHANI_TARGET
+void sha256CompressShaNi(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);             // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);       // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);    // CDGH
+
+    for (size_t n = 0; n < blocks; ++n, data += 64) {
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+        __m128i msg;
+
+        __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0)), MASK);
+        __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), MASK);
+        __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), MASK);
+        __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), MASK);
+
+        SHA256_GROUP(0,  m0, m1, m3, false, false)
+        SHA256_GROUP(1,  m1, m2, m0, false, true)
+        SHA256_GROUP(2,  m2, m3, m1, false, true)
+        SHA256_GROUP(3,  m3, m0, m2, true,  true)
+        SHA256_GROUP(4,  m0, m1, m3, true,  true)
+        SHA256_GROUP(5,  m1, m2, m0, true,  true)
+        SHA256_GROUP(6,  m2, m3, m1, true,  true)
+        SHA256_GROUP(7,  m3, m0, m2, true,  true)
+        SHA256_GROUP(8,  m0, m1, m3, true,  true)
+        SHA256_GROUP(9,  m1, m2, m0, true,  true)
+        SHA256_GROUP(10, m2, m3, m1, true,  true)
+        SHA256_GROUP(11, m3, m0, m2, true,  true)
+        SHA256_GROUP(12, m0, m1, m3, true,  true)
+        SHA256_GROUP(13, m1, m2, m0, true,  false)
+        SHA256_GROUP(14, m2, m3, m1, true,  false)
+        SHA256_GROUP(15, m3, m0, m2, false, false)
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);          // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);       // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);    // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);       // HGFE
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+// Four rounds with round function F. ECUR carries E (plus this group's
+// message words) into the rounds, EOTHER saves ABCD for the next group.
+#define SHA1_GROUP(F, CUR, NEXT, OPP, PREV, ECUR, EOTHER, MSG2, MSG1, XOR)  \
+    ECUR = _mm_sha1nexte_epu32(ECUR, CUR);                                 \
+    EOTHER = abcd;                                                         \
+    if (MSG2) NEXT = _mm_sha1msg2_epu32(NEXT, CUR);                        \
+    abcd = _mm_sha1rnds4_epu32(abcd, ECUR, F);                             \
+    if (MSG1) PREV = _mm_sha1msg1_epu32(PREV, CUR);                        \
+    if (XOR) OPP = _mm_xor_si128(OPP, CUR);
+
+SHANI_TARGET
+void sha1CompressShaNi(uint32_t state[5], const uint8_t* data, size_t blocks) {
+    const __m128i MASK = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+    __m128i e1;
+
+    for (size_t n = 0; n < blocks; ++n, data += 64) {
+        __m128i abcdSave = abcd;
+        __m128i e0Save = e0;
+
+        __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0)), MASK);
+        __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), MASK);
+        __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), MASK);
+        __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), MASK);
+
+        // Rounds 0-3 add E directly instead of rotating it out of ABCD
+        e0 = _mm_add_epi32(e0, m0);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+        SHA1_GROUP(0, m1, m2, m3, m0, e1, e0, false, true,  false)   // 4-7
+        SHA1_GROUP(0, m2, m3, m0, m1, e0, e1, false, true,  true)    // 8-11
+        SHA1_GROUP(0, m3, m0, m1, m2, e1, e0, true,  true,  true)    // 12-15
+        SHA1_GROUP(0, m0, m1, m2, m3, e0, e1, true,  true,  true)    // 16-19
+        SHA1_GROUP(1, m1, m2, m3, m0, e1, e0, true,  true,  true)    // 20-23
+        SHA1_GROUP(1, m2, m3, m0, m1, e0, e1, true,  true,  true)    // 24-27
+        SHA1_GROUP(1, m3, m0, m1, m2, e1, e0, true,  true,  true)    // 28-31
+        SHA1_GROUP(1, m0, m1, m2, m3, e0, e1, true,  true,  true)    // 32-35
+        SHA1_GROUP(1, m1, m2, m3, m0, e1, e0, true,  true,  true)    // 36-39
+        SHA1_GROUP(2, m2, m3, m0, m1, e0, e1, true,  true,  true)    // 40-43
+        SHA1_GROUP(2, m3, m0, m1, m2, e1, e0, true,  true,  true)    // 44-47
+        SHA1_GROUP(2, m0, m1, m2, m3, e0, e1, true,  true,  true)    // 48-51
+        SHA1_GROUP(2, m1, m2, m3, m0, e1, e0, true,  true,  true)    // 52-55
+        SHA1_GROUP(2, m2, m3, m0, m1, e0, e1, true,  true,  true)    // 56-59
+        SHA1_GROUP(3, m3, m0, m1, m2, e1, e0, true,  true,  true)    // 60-63
+        SHA1_GROUP(3, m0, m1, m2, m3, e0, e1, true,  true,  true)    // 64-67
+        SHA1_GROUP(3, m1, m2, m3, m0, e1, e0, true,  false, true)    // 68-71
+        SHA1_GROUP(3, m2, m3, m0, m1, e0, e1, true,  false, false)   // 72-75
+        SHA1_GROUP(3, m3, m0, m1, m2, e1, e0, false, false, false)   // 76-79
+
+        e0 = _mm_sha1nexte_epu32(e0, e0Save);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+    }
+
+    abcd = _mm_shuffle_epi32(abcd, 0x1B);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+    state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+#else
+
+bool shaNiSupported() {
+    return false;
+}
+
+void sha256CompressShaNi(uint32_t*, const uint8_t*, size_t) {}
+void sha1CompressShaNi(uint32_t*, const uint8_t*, size_t) {}
+
+#endif
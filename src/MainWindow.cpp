@@ -2,9 +2,11 @@
 #include "CreateTorrentDialog.h"
 #include "SettingsManager.h"
 #include "RemoveConfirmDialog.h"
+#include "TorrentDetailsDialog.h"
 #include "Resources.h"
 #include "SystemUtils.h"
 #include "PathUtils.h"
+#include "NumberFormat.h"
 #include <FL/Fl.H>
 #include <FL/Fl_Button.H>
 #include <FL/Fl_File_Chooser.H>
@@ -15,6 +17,7 @@
 #include <FL/Fl_Choice.H>
 #include <FL/x.H>
 #include <sstream>
+#include <algorithm>
 #include <cstdint>
 #include <iomanip>
 
@@ -45,6 +48,9 @@ MainWindow::MainWindow(int w, int h, const char* title)
     , m_darkModeBtn(nullptr)
     , m_torrentList(nullptr)
     , m_statusBar(nullptr)
+    , m_filterText(nullptr)
+    , m_filterState(nullptr)
+    , m_filterTracker(nullptr)
     , m_manager(nullptr)
     , m_brightIcon(nullptr)
     , m_darkIcon(nullptr)
@@ -155,6 +161,7 @@ MainWindow::MainWindow(int w, int h, const char* title)
     }
 
     createToolbar();
+    createFilterBar();
     createTorrentList();
     createStatusBar();
     
@@ -166,9 +173,10 @@ MainWindow::MainWindow(int w, int h, const char* title)
     // Restore window state
     restoreWindowState();
     
-    // Set up update timer (100ms for faster alert processing)
+    // Repaints follow engine updates; the timer only does housekeeping.
+    // Its first run comes almost immediately to start measuring latency.
+    loadFrameInterval();
     m_latency = -2; // Initial state: "measuring..."
-    m_latencyTicker = 10; // Trigger measurement almost immediately
     Fl::add_timeout(0.1, updateTimerCallback, this);
 
 #ifdef _WIN32
@@ -191,6 +199,7 @@ MainWindow::~MainWindow() {
     delete m_eyeClosedIcon;
     saveWindowState();
     Fl::remove_timeout(updateTimerCallback, this);
+    Fl::remove_timeout(onPaintTimer, this);
 }
 
 // Menu Bar removed
@@ -299,8 +308,41 @@ void MainWindow::createToolbar() {
     m_toolbar->end();
 }
 
-void MainWindow::createTorrentList() {
+void MainWindow::createFilterBar() {
     int y = MENU_HEIGHT + TOOLBAR_HEIGHT;
+    
+    Fl_Group* filterGroup = new Fl_Group(0, y, w(), FILTER_HEIGHT);
+    filterGroup->begin();
+    
+    // Search text (flexible width), matched against name and save path
+    m_filterText = new Fl_Input(50, y + 3, w() - 400, FILTER_HEIGHT - 6, "Filter:");
+    m_filterText->tooltip("Show torrents whose name or save path contains this text");
+    m_filterText->when(FL_WHEN_CHANGED);
+    m_filterText->callback(onFilterChanged, this);
+    
+    // State, in TorrentItem::State order after "All states"
+    m_filterState = new Fl_Choice(w() - 345, y + 3, 140, FILTER_HEIGHT - 6);
+    m_filterState->add("All states");
+    for (int s = static_cast<int>(TorrentItem::State::Queued); s <= static_cast<int>(TorrentItem::State::Complete); s++) {
+        m_filterState->add(TorrentItem::stateName(static_cast<TorrentItem::State>(s)));
+    }
+    m_filterState->value(0);
+    m_filterState->tooltip("Show torrents in this state");
+    m_filterState->callback(onFilterChanged, this);
+    
+    // Tracker host, filled in as trackers are contacted
+    m_filterTracker = new Fl_Choice(w() - 200, y + 3, 195, FILTER_HEIGHT - 6);
+    m_filterTracker->add("All trackers");
+    m_filterTracker->value(0);
+    m_filterTracker->tooltip("Show torrents announcing to this tracker");
+    m_filterTracker->callback(onFilterChanged, this);
+    
+    filterGroup->end();
+    filterGroup->resizable(m_filterText);
+}
+
+void MainWindow::createTorrentList() {
+    int y = MENU_HEIGHT + TOOLBAR_HEIGHT + FILTER_HEIGHT;
     int list_h = h() - y - STATUS_HEIGHT;
     
     m_torrentList = new TorrentListWidget(0, y, w(), list_h);
@@ -339,31 +381,23 @@ void MainWindow::setTorrentManager(TorrentManager* manager) {
     m_manager = manager;
     
     if (m_manager) {
-        // Set up callbacks
-        m_manager->setOnTorrentAdded([this](TorrentItem* item) {
-            if (m_torrentList) {
-                m_torrentList->addTorrent(item);
-            }
-        });
-        
-        m_manager->setOnTorrentRemoved([this](const std::string& hash) {
-            if (m_torrentList) {
-                m_torrentList->removeTorrent(hash);
-            }
-        });
-        
-        m_manager->setOnTorrentUpdated([this](TorrentItem* item) {
-            if (m_torrentList) {
-                m_torrentList->updateTorrent(item);
-            }
-        });
-        
+        // Set up callbacks. They run on the manager's engine thread, so they
+        // only queue work for the FLTK thread. Adds, removals and status
+        // changes all reach the list through the published snapshot.
         m_manager->setOnStatsUpdated([this]() {
-            updateStatusBar();
+            if (!m_engineUpdatePending.exchange(true)) {
+                if (Fl::awake(onEngineUpdate, this) != 0) {
+                    // Awake queue full: let the next notification retry
+                    m_engineUpdatePending.store(false);
+                }
+            }
         });
         
         m_manager->setOnError([](const std::string& error) {
-            fl_alert("Error: %s", error.c_str());
+            std::string* copy = new std::string(error);
+            if (Fl::awake(onEngineError, copy) != 0) {
+                delete copy;
+            }
         });
         
         // Initial update
@@ -379,6 +413,15 @@ void MainWindow::setTorrentManager(TorrentManager* manager) {
             // Always show dialog for confirmation and file selection
             showAddTorrentDialog(path);
         });
+        m_torrentList->setOnSelectionChanged([this]() {
+            updateToolbar();
+        });
+        m_torrentList->setOnShowDetails([this](const std::string& hash) {
+            if (!m_manager) return;
+            TorrentDetailsDialog* dlg = new TorrentDetailsDialog(m_manager, hash);
+            dlg->show_modal();
+            delete dlg;
+        });
     }
 }
 
@@ -386,25 +429,116 @@ void MainWindow::updateUI() {
     if (!m_manager || !m_torrentList) {
         return;
     }
+    m_uiDirty = false;
+    m_lastPaint = std::chrono::steady_clock::now();
+    
+    // The list and toolbar only depend on torrent statuses, so they are
+    // left alone until a new snapshot is published
+    auto snapshot = m_manager->getSnapshot();
+    uint64_t epoch = snapshot ? snapshot->epoch : 0;
+    if (epoch != m_paintedEpoch || epoch == 0) {
+        m_paintedEpoch = epoch;
+        m_torrentList->setSnapshot(std::move(snapshot));
+        updateTrackerFilter();
+        updateToolbar();
+    }
     
-    // Update torrent list
-    auto torrents = m_manager->getAllTorrents();
-    m_torrentList->setTorrents(torrents);
-    
-    // Update status bar
+    // Session totals change without a new snapshot
     updateStatusBar();
+    
+    // ECO mode gives back what the repaint allocated straight away
+    if (SettingsManager::instance().getRamMode() == 0) {
+        SystemUtils::releaseMemory();
+    }
+}
+
+void MainWindow::loadFrameInterval() {
+    int ms = SettingsManager::instance().getUiRefreshInterval();
+    ms = std::clamp(ms, MIN_FRAME_INTERVAL_MS, MAX_FRAME_INTERVAL_MS);
+    m_frameInterval = ms / 1000.0;
+}
 
-    // Update toolbar
+double MainWindow::currentFrameInterval() const {
+    // Nobody is looking at a minimized or tray-hidden window; keep the list
+    // roughly current so restoring it shows fresh data at once
+    return visible_r() ? m_frameInterval : HIDDEN_FRAME_INTERVAL;
+}
+
+void MainWindow::schedulePaint() {
+    if (m_paintScheduled) return;
+    
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_lastPaint).count();
+    double delay = std::max(0.0, currentFrameInterval() - elapsed);
+    m_paintScheduled = true;
+    Fl::add_timeout(delay, onPaintTimer, this);
+}
+
+void MainWindow::applyFilter() {
+    if (!m_torrentList) return;
+    
+    FilterIndex::Query query;
+    if (m_filterText) query.text = m_filterText->value();
+    if (m_filterState && m_filterState->value() > 0) {
+        query.state = m_filterState->value() - 1;
+    }
+    if (m_filterTracker && m_filterTracker->value() > 0) {
+        query.tracker = m_filterTrackerHosts[m_filterTracker->value() - 1];
+    }
+    m_torrentList->setFilter(query);
     updateToolbar();
 }
 
+void MainWindow::updateTrackerFilter() {
+    if (!m_filterTracker || !m_torrentList) return;
+    
+    std::vector<std::string> hosts = m_torrentList->getFilterIndex().getTrackerHosts();
+    if (hosts == m_filterTrackerHosts) return;
+    
+    // Keep the chosen host selected while the list around it changes
+    std::string selected;
+    if (m_filterTracker->value() > 0) {
+        selected = m_filterTrackerHosts[m_filterTracker->value() - 1];
+    }
+    m_filterTrackerHosts = std::move(hosts);
+    
+    m_filterTracker->clear();
+    m_filterTracker->add("All trackers");
+    int value = 0;
+    for (size_t i = 0; i < m_filterTrackerHosts.size(); i++) {
+        // Host names never contain '/', so add() takes them as plain items
+        m_filterTracker->add(m_filterTrackerHosts[i].c_str());
+        if (m_filterTrackerHosts[i] == selected) value = static_cast<int>(i) + 1;
+    }
+    m_filterTracker->value(value);
+    if (!selected.empty() && value == 0) {
+        // The chosen host has no torrents left
+        applyFilter();
+    }
+}
+
 void MainWindow::updateStatusBar() {
     if (!m_statusBar || !m_manager) {
         return;
     }
     
+    // Relabelling redraws the bar, so only do it when the text changed
     std::string status = formatStatusBar();
-    m_statusBar->copy_label(status.c_str());
+    if (status != m_statusText) {
+        m_statusText = std::move(status);
+        m_statusBar->copy_label(m_statusText.c_str());
+    }
+    
+    // The full session stats show when hovering the bar; they are rebuilt
+    // only when a new stats sample has come in since
+    uint64_t serial = m_manager->getSessionStatsSerial();
+    if (serial != m_statsSerial) {
+        m_statsSerial = serial;
+        std::string stats = m_manager->getSessionStats();
+        if (stats != m_statsText) {
+            m_statsText = std::move(stats);
+            m_statusBar->copy_tooltip(m_statsText.c_str());
+        }
+    }
 }
 
 void MainWindow::updateToolbar() {
@@ -418,9 +552,9 @@ void MainWindow::updateToolbar() {
             
             // Check state of first selected item to determine button state
             bool isPaused = false;
-            auto selected = m_torrentList->getSelectedTorrents();
-            if (!selected.empty()) {
-                isPaused = (selected[0]->getState() == TorrentItem::State::Paused);
+            int idx = m_torrentList->getSelectedIndex();
+            if (idx >= 0) {
+                isPaused = (m_torrentList->getSnapshot()->columns.state[idx] == TorrentItem::State::Paused);
             }
             
             if (isPaused) {
@@ -611,22 +745,44 @@ std::string MainWindow::formatStatusBar() const {
         return "Not initialized";
     }
     
-    int totalTorrents = m_manager->getTorrentCount();
-    int activeTorrents = m_manager->getActiveTorrentsCount();
+    // Counts from one snapshot so they agree with each other; rates and
+    // peers from the session metrics
+    auto snapshot = m_manager->getSnapshot();
+    int totalTorrents = static_cast<int>(snapshot->size());
+    int activeTorrents = snapshot->activeCount;
     int downRate = m_manager->getTotalDownloadRate();
     int upRate = m_manager->getTotalUploadRate();
+    int peers = m_manager->getConnectedPeers();
+    int dhtNodes = m_manager->getDhtNodes();
     
     std::ostringstream oss;
     oss << "Torrents: " << totalTorrents 
         << " (Active: " << activeTorrents << ")  |  ";
     
     if (downRate > 0 || upRate > 0) {
-        oss << "↓ " << TorrentItem::formatSpeed(downRate) << "  "
-            << "↑ " << TorrentItem::formatSpeed(upRate);
+        NumberFormat::Buffer down, up;
+        oss << "↓ " << NumberFormat::speed(down, downRate) << "  "
+            << "↑ " << NumberFormat::speed(up, upRate);
     } else {
         oss << "Idle";
     }
     
+    if (peers > 0) {
+        oss << "  |  Peers: " << peers;
+    }
+    if (dhtNodes > 0) {
+        oss << "  |  DHT: " << dhtNodes;
+    }
+    
+    // Trackers of newly added torrents still waiting for their host's turn
+    size_t queued = 0;
+    for (const auto& queue : m_manager->getAnnounceQueueDepths()) {
+        queued += queue.trackers;
+    }
+    if (queued > 0) {
+        oss << "  |  Announces queued: " << queued;
+    }
+    
     // Add RAM usage
     oss << "  |  RAM: " << SystemUtils::getRamUsage();
     
@@ -695,6 +851,7 @@ void MainWindow::showPreferencesDialog() {
     
     if (dlg->show_modal()) {
         // Settings were saved, might need to apply some changes
+        loadFrameInterval();
         updateUI();
     }
     
@@ -714,17 +871,17 @@ void MainWindow::showAboutDialog() {
 void MainWindow::toggleSelectedTorrents() {
     if (!m_manager || !m_torrentList) return;
     
-    auto selected = m_torrentList->getSelectedTorrents();
-    if (selected.empty()) return;
+    int first = m_torrentList->getSelectedIndex();
+    if (first < 0) return;
 
     // Determine action based on the *first* selected item
-    bool shouldResume = (selected[0]->getState() == TorrentItem::State::Paused);
+    bool shouldResume = (m_torrentList->getSnapshot()->columns.state[first] == TorrentItem::State::Paused);
 
-    for (auto* torrent : selected) {
+    for (const auto& hash : m_torrentList->getSelectedHashes()) {
         if (shouldResume) {
-            m_manager->resumeTorrent(torrent->getHash());
+            m_manager->resumeTorrent(hash);
         } else {
-            m_manager->pauseTorrent(torrent->getHash());
+            m_manager->pauseTorrent(hash);
         }
     }
     
@@ -734,26 +891,21 @@ void MainWindow::toggleSelectedTorrents() {
 void MainWindow::removeSelectedTorrents(bool deleteFiles) {
     if (!m_manager || !m_torrentList) return;
     
-    auto selected = m_torrentList->getSelectedTorrents();
-    if (selected.empty()) return;
+    // Hashes are plain values, so they survive the modal loop below
+    std::vector<std::string> hashes = m_torrentList->getSelectedHashes();
+    if (hashes.empty()) return;
     
-    RemoveConfirmDialog* dlg = new RemoveConfirmDialog(selected.size());
+    RemoveConfirmDialog* dlg = new RemoveConfirmDialog(hashes.size());
     int result = dlg->show_modal();
     bool shouldDeleteFiles = dlg->shouldDeleteFiles();
     delete dlg;
     
     if (result == 1) { // Removed
-        // Collect hashes first to avoid dangling pointers if removals trigger list updates
-        std::vector<std::string> hashes;
-        for (auto* torrent : selected) {
-            if (torrent) {
-                hashes.push_back(torrent->getHash());
-            }
-        }
-        
         for (const auto& hash : hashes) {
             m_manager->removeTorrent(hash, shouldDeleteFiles);
         }
+        m_torrentList->clearSelection();
+        updateToolbar();
     }
 }
 
@@ -791,6 +943,12 @@ void MainWindow::show() {
 }
 
 int MainWindow::handle(int event) {
+    if (event == FL_SHOW && m_uiDirty && m_paintScheduled) {
+        // Restored from minimized/tray: don't wait out the hidden interval
+        Fl::remove_timeout(onPaintTimer, this);
+        m_paintScheduled = false;
+        schedulePaint();
+    }
     if (event == FL_CLOSE) {
         saveWindowState();
 #ifdef _WIN32
@@ -936,16 +1094,12 @@ int MainWindow::win_event_handler(int event) {
             } else if (id == 3) {
                 // Pause all (Optional: could be implemented in manager)
                 if (win->m_manager) {
-                    for (auto* it : win->m_manager->getAllTorrents()) {
-                        win->m_manager->pauseTorrent(it->getHash());
-                    }
+                    win->m_manager->pauseAll();
                 }
             } else if (id == 4) {
                 // Resume all
                 if (win->m_manager) {
-                    for (auto* it : win->m_manager->getAllTorrents()) {
-                        win->m_manager->resumeTorrent(it->getHash());
-                    }
+                    win->m_manager->resumeAll();
                 }
             }
             return 1;
@@ -955,6 +1109,21 @@ int MainWindow::win_event_handler(int event) {
 }
 #endif
 
+// Engine thread handoff
+void MainWindow::onEngineUpdate(void* data) {
+    MainWindow* win = (MainWindow*)data;
+    win->m_engineUpdatePending.store(false);
+    
+    // Coalesce into the next frame rather than repainting per notification
+    win->m_uiDirty = true;
+    win->schedulePaint();
+}
+
+void MainWindow::onEngineError(void* data) {
+    std::unique_ptr<std::string> error((std::string*)data);
+    fl_alert("Error: %s", error->c_str());
+}
+
 // Static callbacks
 void MainWindow::onAddTorrent(Fl_Widget* w, void* data) {
     ((MainWindow*)data)->showAddTorrentDialog();
@@ -998,34 +1167,46 @@ void MainWindow::onRamModeChanged(Fl_Widget* w, void* data) {
     }
 }
 
+void MainWindow::onFilterChanged(Fl_Widget* w, void* data) {
+    MainWindow* win = (MainWindow*)data;
+    if (win) {
+        win->applyFilter();
+    }
+}
+
 void MainWindow::updateTimerCallback(void* data) {
     MainWindow* win = (MainWindow*)data;
     
+    // libtorrent work happens on the manager's engine thread and repaints
+    // follow its updates; this timer only does housekeeping
     if (win && win->m_manager) {
-        win->m_manager->update();
-        win->updateToolbar(); // Keep toolbar updated as selection might change or items might disappear
-
-        // Latency update every second (10 * 0.1s)
-        win->m_latencyTicker++;
-        if (win->m_latencyTicker >= 10) {
-            win->m_latencyTicker = 0;
+        // Latency only feeds the status bar, so skip it while nobody sees it
+        if (win->visible_r()) {
             // Run latency measurement in a separate thread to avoid UI freeze
             std::thread([win]() {
                 int lat = SystemUtils::measureLatency();
+                win->m_latency = lat;
                 // Pass back to UI thread safely via Fl::awake
                 Fl::awake([](void* d) {
                     MainWindow* w = (MainWindow*)d;
                     w->updateStatusBar();
                 }, win);
-                win->m_latency = lat;
             }).detach();
         }
 
-        // En Modo ECO, forzamos la liberación de memoria de forma agresiva cada 100ms
+        // En Modo ECO, forzamos la liberación de memoria también en reposo
         if (SettingsManager::instance().getRamMode() == 0) {
             SystemUtils::releaseMemory();
         }
     }
     
-    Fl::repeat_timeout(0.1, updateTimerCallback, data);
+    Fl::repeat_timeout(HOUSEKEEPING_INTERVAL, updateTimerCallback, data);
+}
+
+void MainWindow::onPaintTimer(void* data) {
+    MainWindow* win = (MainWindow*)data;
+    win->m_paintScheduled = false;
+    if (win->m_uiDirty) {
+        win->updateUI();
+    }
 }
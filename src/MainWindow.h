@@ -5,7 +5,11 @@
 #include <FL/Fl_Menu_Bar.H>
 #include <FL/Fl_Pack.H>
 #include <FL/Fl_Box.H>
+#include <FL/Fl_Input.H>
+#include <FL/Fl_Choice.H>
 #include <memory>
+#include <atomic>
+#include <chrono>
 #include "TorrentManager.h"
 #include "TorrentListWidget.h"
 #include "PreferencesDialog.h"
@@ -71,6 +75,10 @@ private:
     Fl_Button* m_btnCensor;
     Fl_Button* m_btnLimit;
     Fl_Choice* m_choiceRamMode;
+    Fl_Input* m_filterText;
+    Fl_Choice* m_filterState;
+    Fl_Choice* m_filterTracker;
+    std::vector<std::string> m_filterTrackerHosts;  // entries of m_filterTracker after "All trackers"
     bool m_limitModerate;
     bool m_censored;
     
@@ -90,15 +98,38 @@ private:
     
     // Latency measurement
     int m_latency = -1;
-    int m_latencyTicker = 0;
+    
+    // Set while an engine update is queued with Fl::awake, so a burst of
+    // engine notifications costs a single UI refresh
+    std::atomic<bool> m_engineUpdatePending{false};
+    
+    // Repaint scheduling: engine updates mark the UI dirty and a repaint
+    // runs at most once per frame interval, and not at all when the
+    // snapshot has not changed since the last one
+    double m_frameInterval = 0.1;       // seconds, from the UI refresh setting
+    bool m_uiDirty = false;
+    bool m_paintScheduled = false;
+    uint64_t m_paintedEpoch = 0;
+    std::string m_statusText;
+    std::string m_statsText;    // session stats, the status bar's tooltip
+    uint64_t m_statsSerial = 0; // sample m_statsText was built from
+    std::chrono::steady_clock::time_point m_lastPaint;
     
     // Layout constants
     static constexpr int MENU_HEIGHT = 0;
     static constexpr int TOOLBAR_HEIGHT = 40;
+    static constexpr int FILTER_HEIGHT = 30;
+    
+    // Refresh timing
+    static constexpr double HIDDEN_FRAME_INTERVAL = 1.0;   // minimized or in the tray
+    static constexpr double HOUSEKEEPING_INTERVAL = 1.0;   // latency, ECO memory release
+    static constexpr int MIN_FRAME_INTERVAL_MS = 16;
+    static constexpr int MAX_FRAME_INTERVAL_MS = 2000;
     static constexpr int STATUS_HEIGHT = 25;
     
     // UI Creation
     void createToolbar();
+    void createFilterBar();
     void createTorrentList();
     void createStatusBar();
     
@@ -115,14 +146,25 @@ private:
     static void onToggleLimit(Fl_Widget* w, void* data);
     static void onToggleCensorship(Fl_Widget* w, void* data);
     static void onRamModeChanged(Fl_Widget* w, void* data);
+    static void onFilterChanged(Fl_Widget* w, void* data);
     
     // Update timer
     static void updateTimerCallback(void* data);
+    static void onPaintTimer(void* data);
+    
+    // Engine thread -> UI thread handoff (run via Fl::awake)
+    static void onEngineUpdate(void* data);
+    static void onEngineError(void* data);
     
     // Helper methods
     void saveWindowState();
     void restoreWindowState();
     std::string formatStatusBar() const;
+    void applyFilter();
+    void loadFrameInterval();
+    double currentFrameInterval() const;
+    void schedulePaint();
+    void updateTrackerFilter();
     std::string getRamUsage() const;
 
 #ifdef _WIN32
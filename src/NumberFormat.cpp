@@ -0,0 +1,268 @@
+#include "NumberFormat.h"
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr std::string_view SIZE_UNITS[] = { "B", "KB", "MB", "GB", "TB" };
+    constexpr int SIZE_UNIT_COUNT = sizeof(SIZE_UNITS) / sizeof(SIZE_UNITS[0]);
+
+    // Appends to a fixed buffer, silently truncating (the buffer is sized
+    // for the longest value any formatter produces)
+    class Writer {
+    public:
+        explicit Writer(NumberFormat::Buffer& buffer)
+            : m_begin(buffer)
+            , m_p(buffer)
+            , m_end(buffer + NumberFormat::BUFFER_SIZE - 1)
+        {
+        }
+
+        void put(std::string_view text) {
+            size_t n = std::min(text.size(), static_cast<size_t>(m_end - m_p));
+            std::memcpy(m_p, text.data(), n);
+            m_p += n;
+        }
+
+        void put(char c) {
+            if (m_p < m_end) *m_p++ = c;
+        }
+
+        void put(int64_t value) {
+            auto result = std::to_chars(m_p, m_end, value);
+            if (result.ec == std::errc()) m_p = result.ptr;
+        }
+
+        // Correctly rounded, the same digits as ostream << std::fixed
+        void putFixed(double value, int decimals) {
+            decimals = std::clamp(decimals, 0, NumberFormat::MAX_DECIMALS);
+            auto result = std::to_chars(m_p, m_end, value, std::chars_format::fixed, decimals);
+            if (result.ec == std::errc()) m_p = result.ptr;
+        }
+
+        std::string_view finish() {
+            *m_p = '\0';
+            return std::string_view(m_begin, static_cast<size_t>(m_p - m_begin));
+        }
+
+    private:
+        char* m_begin;
+        char* m_p;
+        char* m_end;
+    };
+
+    void putSize(Writer& w, int64_t bytes) {
+        int unit = 0;
+        double size = static_cast<double>(bytes);
+        while (size >= 1024 && unit < SIZE_UNIT_COUNT - 1) {
+            size /= 1024;
+            unit++;
+        }
+        w.putFixed(size, 2);
+        w.put(' ');
+        w.put(SIZE_UNITS[unit]);
+    }
+
+    // The ostringstream formatting the UI used before, kept as the baseline
+    // for runBenchmark()
+    std::string legacySize(int64_t bytes) {
+        const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+        int unit = 0;
+        double size = static_cast<double>(bytes);
+        while (size >= 1024 && unit < 4) {
+            size /= 1024;
+            unit++;
+        }
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(2) << size << " " << units[unit];
+        return oss.str();
+    }
+
+    std::string legacySpeed(int bytesPerSecond) {
+        if (bytesPerSecond <= 0) return "0 B/s";
+        return legacySize(bytesPerSecond) + "/s";
+    }
+
+    std::string legacyEta(int seconds) {
+        if (seconds < 0) return "∞";
+        if (seconds == 0) return "Done";
+        int h = seconds / 3600;
+        int m = (seconds % 3600) / 60;
+        int s = seconds % 60;
+        std::ostringstream oss;
+        if (h > 0) oss << h << "h " << m << "m " << s << "s";
+        else if (m > 0) oss << m << "m " << s << "s";
+        else oss << s << "s";
+        return oss.str();
+    }
+
+    std::string legacyFixed(double value, int decimals) {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(decimals) << value;
+        return oss.str();
+    }
+
+    std::string legacyPeers(int peers, int seeds) {
+        std::ostringstream oss;
+        oss << peers << " (" << seeds << ")";
+        return oss.str();
+    }
+
+    struct BenchRow {
+        int64_t size;
+        int down;
+        int up;
+        int eta;
+        double ratio;
+        double progress;
+        int peers;
+        int seeds;
+    };
+
+    constexpr int CELLS_PER_ROW = 7;
+
+    template <typename FormatRow>
+    double measureCellsPerSecond(const std::vector<BenchRow>& rows, FormatRow formatRow, size_t& checksum) {
+        size_t cells = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        while (seconds < 0.5) {
+            for (const BenchRow& row : rows) {
+                checksum += formatRow(row);
+                cells += CELLS_PER_ROW;
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return cells / seconds;
+    }
+}
+
+std::string_view NumberFormat::size(Buffer& out, int64_t bytes) {
+    Writer w(out);
+    putSize(w, bytes);
+    return w.finish();
+}
+
+std::string_view NumberFormat::speed(Buffer& out, int64_t bytesPerSecond) {
+    Writer w(out);
+    if (bytesPerSecond <= 0) {
+        w.put("0 B/s");
+    } else {
+        putSize(w, bytesPerSecond);
+        w.put("/s");
+    }
+    return w.finish();
+}
+
+std::string_view NumberFormat::time(Buffer& out, int seconds) {
+    Writer w(out);
+    if (seconds < 0) {
+        w.put("∞");
+        return w.finish();
+    }
+
+    int h = seconds / 3600;
+    int m = (seconds % 3600) / 60;
+    int s = seconds % 60;
+    if (h > 0) {
+        w.put(static_cast<int64_t>(h));
+        w.put("h ");
+    }
+    if (h > 0 || m > 0) {
+        w.put(static_cast<int64_t>(m));
+        w.put("m ");
+    }
+    w.put(static_cast<int64_t>(s));
+    w.put('s');
+    return w.finish();
+}
+
+std::string_view NumberFormat::eta(Buffer& out, int seconds) {
+    if (seconds == 0) {
+        Writer w(out);
+        w.put("Done");
+        return w.finish();
+    }
+    return time(out, seconds);
+}
+
+std::string_view NumberFormat::fixed(Buffer& out, double value, int decimals) {
+    Writer w(out);
+    w.putFixed(value, decimals);
+    return w.finish();
+}
+
+std::string_view NumberFormat::percent(Buffer& out, double fraction, int decimals) {
+    Writer w(out);
+    w.putFixed(fraction * 100.0, decimals);
+    w.put('%');
+    return w.finish();
+}
+
+std::string_view NumberFormat::peers(Buffer& out, int peers, int seeds) {
+    Writer w(out);
+    w.put(static_cast<int64_t>(peers));
+    w.put(" (");
+    w.put(static_cast<int64_t>(seeds));
+    w.put(')');
+    return w.finish();
+}
+
+int NumberFormat::runBenchmark() {
+    // A 10k-torrent list with plausible values
+    std::vector<BenchRow> rows(10000);
+    uint32_t x = 0x12345678;
+    auto next = [&x]() { x ^= x << 13; x ^= x >> 17; x ^= x << 5; return x; };
+    for (BenchRow& row : rows) {
+        row.size = static_cast<int64_t>(next()) * (next() % 4096);
+        row.down = static_cast<int>(next() % (50 * 1024 * 1024));
+        row.up = static_cast<int>(next() % (5 * 1024 * 1024));
+        row.eta = static_cast<int>(next() % 200000) - 1;
+        row.ratio = (next() % 100000) / 1000.0;
+        row.progress = (next() % 100001) / 100000.0;
+        row.peers = static_cast<int>(next() % 500);
+        row.seeds = static_cast<int>(next() % 200);
+    }
+
+    // Both paths must produce the same text before their speed means anything
+    for (const BenchRow& row : rows) {
+        Buffer buf;
+        bool same = legacySize(row.size) == size(buf, row.size)
+            && legacySpeed(row.down) == speed(buf, row.down)
+            && legacyEta(row.eta) == eta(buf, row.eta)
+            && legacyFixed(row.ratio, 2) == fixed(buf, row.ratio, 2)
+            && legacyFixed(row.progress * 100.0, 1) + "%" == percent(buf, row.progress, 1)
+            && legacyPeers(row.peers, row.seeds) == peers(buf, row.peers, row.seeds);
+        if (!same) {
+            std::cerr << "NumberFormat output differs from ostringstream for size " << row.size
+                      << ", ratio " << row.ratio << ", progress " << row.progress << std::endl;
+            return 1;
+        }
+    }
+
+    size_t checksum = 0;
+    double before = measureCellsPerSecond(rows, [](const BenchRow& row) {
+        return legacySize(row.size).size() + legacySpeed(row.down).size() + legacySpeed(row.up).size()
+            + legacyEta(row.eta).size() + legacyFixed(row.ratio, 2).size()
+            + (legacyFixed(row.progress * 100.0, 1) + "%").size() + legacyPeers(row.peers, row.seeds).size();
+    }, checksum);
+    double after = measureCellsPerSecond(rows, [](const BenchRow& row) {
+        Buffer buf;
+        return size(buf, row.size).size() + speed(buf, row.down).size() + speed(buf, row.up).size()
+            + eta(buf, row.eta).size() + fixed(buf, row.ratio, 2).size()
+            + percent(buf, row.progress, 1).size() + peers(buf, row.peers, row.seeds).size();
+    }, checksum);
+
+    std::cout << "Formatted cells per second (" << rows.size() << " rows x " << CELLS_PER_ROW << " cells)" << std::endl;
+    std::cout << std::left << std::setw(16) << "ostringstream" << static_cast<int64_t>(before) << std::endl;
+    std::cout << std::left << std::setw(16) << "NumberFormat" << static_cast<int64_t>(after) << std::endl;
+    std::cout << "Speed-up: " << std::fixed << std::setprecision(1) << after / before << "x"
+              << " (checksum " << checksum << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Allocation-free formatting of sizes, speeds, times and ratios
+ *
+ * Every function writes into a caller-provided stack buffer with
+ * std::to_chars and returns a view of the NUL-terminated result, so the
+ * draw paths (torrent list, details dialog, status bar) format numbers
+ * without touching the heap. TorrentItem::formatSize() and friends wrap
+ * these for code that wants a std::string.
+ */
+class NumberFormat {
+public:
+    static constexpr size_t BUFFER_SIZE = 48;
+    using Buffer = char[BUFFER_SIZE];
+
+    static std::string_view size(Buffer& out, int64_t bytes);            // "1.50 MB"
+    static std::string_view speed(Buffer& out, int64_t bytesPerSecond);  // "1.50 MB/s", "0 B/s"
+    static std::string_view time(Buffer& out, int seconds);              // "1h 2m 3s", "∞" if negative
+    static std::string_view eta(Buffer& out, int seconds);               // time(), "Done" at 0
+    static std::string_view fixed(Buffer& out, double value, int decimals);
+    static std::string_view percent(Buffer& out, double fraction, int decimals);  // 0.5 -> "50.0%"
+    static std::string_view peers(Buffer& out, int peers, int seeds);    // "12 (3)"
+
+    // Formats a table's worth of cells with the old ostringstream code and
+    // with this module and prints cells per second. Returns an exit code.
+    static int runBenchmark();
+
+    static constexpr int MAX_DECIMALS = 4;
+};
+
+#endif // NUMBERFORMAT_H
@@ -0,0 +1,127 @@
+#include "PiecePlanner.h"
+#include "TorrentItem.h"
+#include <libtorrent/create_torrent.hpp>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    // Rough bencoded sizes, enough to compare piece sizes against each other
+    constexpr int64_t BASE_BYTES = 256;             // name, piece length, creator, dates
+    constexpr int64_t V1_FILE_BYTES = 32;           // d6:lengthi...e4:pathl...ee
+    constexpr int64_t V1_PAD_FILE_BYTES = 48;       // same, plus attr "p" and ".pad/N"
+    constexpr int64_t V2_FILE_BYTES = 80;           // file tree node with its pieces root
+    constexpr int64_t V2_LAYER_BYTES = 40;          // piece layers key and length prefix
+    constexpr int64_t V1_HASH = 20;
+    constexpr int64_t V2_HASH = 32;
+
+    int64_t divideUp(int64_t a, int64_t b) {
+        return (a + b - 1) / b;
+    }
+}
+
+PiecePlanner::Layout PiecePlanner::scan(const std::string& source) {
+    lt::file_storage storage;
+    try {
+        lt::add_files(storage, source);
+    } catch (const std::exception& e) {
+        std::cerr << "Error scanning " << source << ": " << e.what() << std::endl;
+        return Layout();
+    }
+    return fromStorage(storage);
+}
+
+PiecePlanner::Layout PiecePlanner::fromStorage(const lt::file_storage& storage) {
+    Layout layout;
+    layout.fileSizes.reserve(storage.num_files());
+    for (lt::file_index_t i : storage.file_range()) {
+        if (storage.pad_file_at(i)) continue;
+        int64_t size = storage.file_size(i);
+        layout.fileSizes.push_back(size);
+        layout.totalSize += size;
+        layout.pathBytes += static_cast<int64_t>(storage.file_path(i).size());
+    }
+    return layout;
+}
+
+PiecePlanner::Plan PiecePlanner::estimate(const Layout& layout, int pieceSize, TorrentCreator::Format format, bool aligned) {
+    const bool v1 = format != TorrentCreator::Format::V2Only;
+    const bool v2 = format != TorrentCreator::Format::V1Only;
+    aligned = aligned || v2;
+
+    Plan plan;
+    plan.pieceSize = pieceSize;
+
+    int64_t padFiles = 0;
+    int64_t layerBytes = 0;
+    const size_t count = layout.fileSizes.size();
+    for (size_t i = 0; i < count; ++i) {
+        int64_t size = layout.fileSizes[i];
+        // The last file is never padded
+        if (aligned && i + 1 < count && size % pieceSize != 0) {
+            plan.paddingBytes += pieceSize - size % pieceSize;
+            padFiles++;
+        }
+        // Files that fit in one piece have no piece layer, the root covers them
+        if (v2 && size > pieceSize) {
+            layerBytes += V2_LAYER_BYTES + V2_HASH * divideUp(size, pieceSize);
+        }
+    }
+    plan.numPieces = std::max<int64_t>(1, divideUp(layout.totalSize + plan.paddingBytes, pieceSize));
+
+    const bool multiFile = count > 1;
+    plan.metadataBytes = BASE_BYTES;
+    if (v1) {
+        plan.metadataBytes += V1_HASH * plan.numPieces;
+        if (multiFile) {
+            plan.metadataBytes += V1_FILE_BYTES * static_cast<int64_t>(count) + layout.pathBytes
+                + V1_PAD_FILE_BYTES * padFiles;
+        }
+    }
+    if (v2) {
+        plan.metadataBytes += V2_FILE_BYTES * static_cast<int64_t>(count) + layout.pathBytes + layerBytes;
+    }
+    return plan;
+}
+
+PiecePlanner::Plan PiecePlanner::choose(const Layout& layout, TorrentCreator::Format format, bool aligned) {
+    Plan best;
+    double bestScore = -1.0;
+    for (int64_t size = MIN_PIECE_SIZE; size <= MAX_PIECE_SIZE; size *= 2) {
+        Plan plan = estimate(layout, static_cast<int>(size), format, aligned);
+
+        double outside = 0.0;
+        if (plan.numPieces > MAX_PIECES) {
+            outside = std::log2(static_cast<double>(plan.numPieces) / MAX_PIECES);
+        } else if (plan.numPieces < MIN_PIECES && size > MIN_PIECE_SIZE) {
+            // Small torrents get few pieces whatever we do; only penalise
+            // sizes that made the count drop below the range
+            outside = std::log2(static_cast<double>(MIN_PIECES) / plan.numPieces);
+        }
+        double cost = static_cast<double>(plan.metadataBytes)
+            + static_cast<double>(plan.paddingBytes) / PADDING_DISCOUNT;
+        double score = cost * std::pow(RANGE_PENALTY, outside);
+
+        // Strictly better only: on a tie the smaller piece wins
+        if (bestScore < 0.0 || score < bestScore) {
+            best = plan;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+std::string PiecePlanner::formatPieceSize(int pieceSize) {
+    if (pieceSize >= 1024 * 1024) {
+        return std::to_string(pieceSize / (1024 * 1024)) + " MiB";
+    }
+    return std::to_string(pieceSize / 1024) + " KiB";
+}
+
+std::string PiecePlanner::describe(const Plan& plan) {
+    std::string text = formatPieceSize(plan.pieceSize) + " × " + std::to_string(plan.numPieces)
+        + " pieces, ~" + TorrentItem::formatSize(plan.metadataBytes) + " metadata";
+    if (plan.paddingBytes > 0) {
+        text += ", " + TorrentItem::formatSize(plan.paddingBytes) + " padding";
+    }
+    return text;
+}
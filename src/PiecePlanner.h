@@ -0,0 +1,64 @@
+#ifndef PIECEPLANNER_H
+#define PIECEPLANNER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <libtorrent/file_storage.hpp>
+#include "TorrentCreator.h"
+
+namespace lt = libtorrent;
+
+/**
+ * @brief Chooses the piece size for a new torrent
+ *
+ * Every power of two from 16 KiB to 64 MiB is scored on the estimated
+ * .torrent size (v1 piece hashes, v2 piece layers, file entries and pad
+ * file entries) plus the alignment padding it causes. Candidates whose
+ * piece count falls outside [MIN_PIECES, MAX_PIECES] are penalised
+ * exponentially by how far outside they are, so the result stays in range whenever the file
+ * layout allows it. Padding is counted at a discount: it is never stored,
+ * but v1 clients that don't know pad files still download it.
+ */
+class PiecePlanner {
+public:
+    struct Layout {
+        std::vector<int64_t> fileSizes;    // in torrent order
+        int64_t totalSize = 0;
+        int64_t pathBytes = 0;             // sum of relative path lengths
+    };
+
+    struct Plan {
+        int pieceSize = 0;
+        int64_t numPieces = 0;
+        int64_t metadataBytes = 0;         // estimated .torrent size
+        int64_t paddingBytes = 0;
+    };
+
+    // Files under source (UTF-8), as lt::add_files would list them
+    static Layout scan(const std::string& source);
+    static Layout fromStorage(const lt::file_storage& storage);
+
+    // aligned: files start on piece boundaries (always true for v2/hybrid)
+    static Plan estimate(const Layout& layout, int pieceSize, TorrentCreator::Format format, bool aligned);
+    static Plan choose(const Layout& layout, TorrentCreator::Format format, bool aligned);
+
+    // "1 MiB × 1024 pieces, ~52.27 KB metadata"
+    static std::string describe(const Plan& plan);
+    // "16 KiB", "4 MiB"
+    static std::string formatPieceSize(int pieceSize);
+
+    static constexpr int MIN_PIECE_SIZE = 16 * 1024;
+    static constexpr int MAX_PIECE_SIZE = 64 * 1024 * 1024;
+    static constexpr int64_t MIN_PIECES = 1024;
+    static constexpr int64_t MAX_PIECES = 4096;
+
+private:
+    // One byte of metadata costs as much as this many bytes of padding
+    static constexpr int64_t PADDING_DISCOUNT = 64;
+    // Score multiplier per doubling outside the piece-count range; above 2
+    // so halving the piece hashes never pays for leaving the range
+    static constexpr double RANGE_PENALTY = 4.0;
+};
+
+#endif // PIECEPLANNER_H
@@ -55,6 +55,16 @@ void PreferencesDialog::createGeneralTab() {
     // Minimize to tray
     m_minimizeToTray = new Fl_Check_Button(20, 150, 250, 25, "Minimize to system tray");
     
+    // UI refresh interval
+    Fl_Box* refreshLabel = new Fl_Box(20, 190, 150, 25, "UI Refresh Interval:");
+    refreshLabel->align(FL_ALIGN_LEFT | FL_ALIGN_INSIDE);
+    
+    m_uiRefreshInterval = new Fl_Int_Input(180, 190, 100, 25);
+    m_uiRefreshInterval->value("100");
+    
+    Fl_Box* refreshUnit = new Fl_Box(290, 190, 250, 25, "ms (1 s while minimized)");
+    refreshUnit->align(FL_ALIGN_LEFT | FL_ALIGN_INSIDE);
+    
     m_generalTab->end();
 }
 
@@ -187,6 +197,9 @@ void PreferencesDialog::loadSettings() {
     m_downloadPath->value(settings.getDefaultSavePath().c_str());
     m_startWithSystem->value(settings.getStartWithSystem() ? 1 : 0);
     m_minimizeToTray->value(settings.getMinimizeToTray() ? 1 : 0);
+    std::ostringstream refresh;
+    refresh << settings.getUiRefreshInterval();
+    m_uiRefreshInterval->value(refresh.str().c_str());
     
     // Connection
     std::ostringstream port, maxDown, maxUp, maxConn;
@@ -217,6 +230,7 @@ void PreferencesDialog::saveSettings() {
     settings.setDefaultSavePath(m_downloadPath->value());
     settings.setStartWithSystem(m_startWithSystem->value() != 0);
     settings.setMinimizeToTray(m_minimizeToTray->value() != 0);
+    settings.setUiRefreshInterval(atoi(m_uiRefreshInterval->value()));
     
     // Connection
     settings.setListenPort(atoi(m_listenPort->value()));
@@ -259,6 +273,14 @@ bool PreferencesDialog::validateSettings() {
         return false;
     }
     
+    // Validate UI refresh interval
+    int refresh = atoi(m_uiRefreshInterval->value());
+    if (refresh < 16 || refresh > 2000) {
+        fl_alert("UI refresh interval must be between 16 and 2000 ms");
+        m_tabs->value(m_generalTab);
+        return false;
+    }
+    
     // Validate connection limits
     int maxConn = atoi(m_maxConnections->value());
     if (maxConn < 2 || maxConn > 10000) {
@@ -0,0 +1,235 @@
+#include "ResumeDataWriter.h"
+#include "ResumeStore.h"
+#include <iostream>
+#include <filesystem>
+#include <cstdio>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace fs = std::filesystem;
+
+ResumeDataWriter::ResumeDataWriter(const std::string& directory, ResumeStore* store)
+    : m_directory(directory)
+    , m_store(store)
+    , m_stopping(false)
+    , m_running(false)
+    , m_bytesWritten(0)
+    , m_filesWritten(0)
+    , m_filesRemoved(0)
+    , m_writeErrors(0)
+{
+}
+
+ResumeDataWriter::~ResumeDataWriter() {
+    stop();
+}
+
+void ResumeDataWriter::start() {
+    if (m_running) {
+        return;
+    }
+    m_stopping = false;
+    m_running = true;
+    m_thread = std::thread(&ResumeDataWriter::run, this);
+}
+
+void ResumeDataWriter::stop() {
+    if (!m_running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_running = false;
+}
+
+void ResumeDataWriter::write(const std::string& hash, std::vector<char> data) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending[hash] = Job{false, std::move(data)};
+    }
+    m_cv.notify_one();
+}
+
+void ResumeDataWriter::remove(const std::string& hash) {
+    {
+        // Replaces any write still queued for this torrent
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending[hash] = Job{true, {}};
+    }
+    m_cv.notify_one();
+}
+
+ResumeDataWriter::Stats ResumeDataWriter::getStats() const {
+    Stats stats;
+    stats.bytesWritten = m_bytesWritten.load();
+    stats.filesWritten = m_filesWritten.load();
+    stats.filesRemoved = m_filesRemoved.load();
+    stats.writeErrors = m_writeErrors.load();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.queueDepth = m_pending.size();
+    }
+    return stats;
+}
+
+void ResumeDataWriter::run() {
+    std::unordered_map<std::string, Job> batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+
+            if (!m_stopping) {
+                // Let the rest of a save_resume_data burst arrive
+                m_cv.wait_for(lock, BATCH_WINDOW, [this]() { return m_stopping; });
+            }
+            if (m_pending.empty() && m_stopping) {
+                break;
+            }
+            batch.swap(m_pending);
+        }
+
+        processBatch(batch);
+        batch.clear();
+    }
+}
+
+void ResumeDataWriter::processBatch(std::unordered_map<std::string, Job>& batch) {
+    if (m_store) {
+        processStoreBatch(batch);
+        return;
+    }
+
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+
+    struct TempFile {
+        std::string tmpPath;
+        std::string finalPath;
+        FILE* file;
+        size_t size;
+    };
+    std::vector<TempFile> open;
+    open.reserve(std::min(batch.size(), MAX_OPEN_FILES));
+    bool renamed = false;
+
+    // fsync every temp file of a chunk back to back, then rename them all
+    auto flushChunk = [&]() {
+        for (auto& t : open) {
+            bool ok = std::fflush(t.file) == 0;
+#ifdef _WIN32
+            ok = ok && _commit(_fileno(t.file)) == 0;
+#else
+            ok = ok && ::fsync(fileno(t.file)) == 0;
+#endif
+            ok = (std::fclose(t.file) == 0) && ok;
+
+            std::error_code renameEc;
+            if (ok) {
+                fs::rename(t.tmpPath, t.finalPath, renameEc);
+            }
+            if (!ok || renameEc) {
+                std::cerr << "Failed to write resume data: " << t.finalPath << std::endl;
+                fs::remove(t.tmpPath, renameEc);
+                m_writeErrors++;
+                continue;
+            }
+            renamed = true;
+            m_bytesWritten += t.size;
+            m_filesWritten++;
+        }
+        open.clear();
+    };
+
+    for (auto& [hash, job] : batch) {
+        std::string finalPath = pathFor(hash);
+
+        if (job.remove) {
+            std::error_code removeEc;
+            if (fs::remove(finalPath, removeEc)) {
+                m_filesRemoved++;
+            }
+            continue;
+        }
+
+        std::string tmpPath = finalPath + ".tmp";
+        FILE* f = std::fopen(tmpPath.c_str(), "wb");
+        if (!f) {
+            std::cerr << "Failed to open resume data file: " << tmpPath << std::endl;
+            m_writeErrors++;
+            continue;
+        }
+        if (std::fwrite(job.data.data(), 1, job.data.size(), f) != job.data.size()) {
+            std::cerr << "Failed to write resume data: " << tmpPath << std::endl;
+            std::fclose(f);
+            fs::remove(tmpPath, ec);
+            m_writeErrors++;
+            continue;
+        }
+        open.push_back({tmpPath, finalPath, f, job.data.size()});
+
+        if (open.size() >= MAX_OPEN_FILES) {
+            flushChunk();
+        }
+    }
+    flushChunk();
+
+    // Make the renames themselves durable, once per batch
+    if (renamed) {
+        syncDirectory();
+    }
+}
+
+void ResumeDataWriter::processStoreBatch(std::unordered_map<std::string, Job>& batch) {
+    std::vector<ResumeStore::Record> records;
+    records.reserve(batch.size());
+    uint64_t bytes = 0;
+    uint64_t written = 0;
+    uint64_t removed = 0;
+    for (const auto& [hash, job] : batch) {
+        records.push_back({hash, job.remove, &job.data});
+        if (job.remove) {
+            removed++;
+        } else {
+            bytes += job.data.size();
+            written++;
+        }
+    }
+
+    if (!m_store->append(records)) {
+        m_writeErrors += records.size();
+        return;
+    }
+    m_bytesWritten += bytes;
+    m_filesWritten += written;
+    m_filesRemoved += removed;
+
+    m_store->compactIfNeeded();
+}
+
+std::string ResumeDataWriter::pathFor(const std::string& hash) const {
+    return m_directory + "/" + hash + ".fastresume";
+}
+
+void ResumeDataWriter::syncDirectory() {
+#ifndef _WIN32
+    int fd = ::open(m_directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#endif
+}
@@ -0,0 +1,83 @@
+#ifndef RESUMEDATAWRITER_H
+#define RESUMEDATAWRITER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+class ResumeStore;
+
+/**
+ * @brief Background writer for .fastresume files
+ *
+ * Bencoded resume data is queued from the alert handler and written on a
+ * dedicated thread. Saves for the same torrent coalesce (latest wins), and
+ * every file is replaced atomically: written to a temp file, flushed to
+ * disk, then renamed over the old one. The fsyncs of a batch are issued
+ * together and the directory is synced once per batch.
+ *
+ * When given a ResumeStore, a batch is instead appended to the store's log
+ * as a single write (files/bytes then count records).
+ */
+class ResumeDataWriter {
+public:
+    struct Stats {
+        uint64_t bytesWritten;
+        uint64_t filesWritten;
+        uint64_t filesRemoved;
+        uint64_t writeErrors;
+        size_t queueDepth;
+    };
+
+    explicit ResumeDataWriter(const std::string& directory, ResumeStore* store = nullptr);
+    ~ResumeDataWriter();
+
+    void start();
+    // Writes everything still queued, then joins the thread
+    void stop();
+
+    // Queue <hash>.fastresume for writing / deletion
+    void write(const std::string& hash, std::vector<char> data);
+    void remove(const std::string& hash);
+
+    Stats getStats() const;
+
+private:
+    struct Job {
+        bool remove;
+        std::vector<char> data;
+    };
+
+    std::string m_directory;
+    ResumeStore* m_store;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::unordered_map<std::string, Job> m_pending; // protected by m_mutex
+    bool m_stopping;                                 // protected by m_mutex
+    bool m_running;
+
+    std::atomic<uint64_t> m_bytesWritten;
+    std::atomic<uint64_t> m_filesWritten;
+    std::atomic<uint64_t> m_filesRemoved;
+    std::atomic<uint64_t> m_writeErrors;
+
+    // Short delay after the first job so a burst of alerts lands in one batch
+    static constexpr std::chrono::milliseconds BATCH_WINDOW{250};
+    // Temp files kept open at once while their fsyncs are issued
+    static constexpr size_t MAX_OPEN_FILES = 64;
+
+    void run();
+    void processBatch(std::unordered_map<std::string, Job>& batch);
+    void processStoreBatch(std::unordered_map<std::string, Job>& batch);
+    std::string pathFor(const std::string& hash) const;
+    void syncDirectory();
+};
+
+#endif // RESUMEDATAWRITER_H
@@ -0,0 +1,189 @@
+#include "ResumeLoader.h"
+#include "ResumeStore.h"
+#include <libtorrent/read_resume_data.hpp>
+#include <libtorrent/torrent_flags.hpp>
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    int64_t elapsedUs(Clock::time_point since) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count();
+    }
+}
+
+ResumeLoader::ResumeLoader(const std::string& directory, ResumeStore* store, AddCallback add)
+    : m_directory(directory)
+    , m_store(store)
+    , m_add(std::move(add))
+    , m_running(false)
+    , m_cancel(false)
+    , m_loaded(0)
+    , m_failed(0)
+    , m_readUs(0)
+    , m_parseUs(0)
+    , m_addUs(0)
+{
+}
+
+ResumeLoader::~ResumeLoader() {
+    stop();
+}
+
+void ResumeLoader::start() {
+    if (m_thread.joinable()) {
+        return;
+    }
+    m_cancel.store(false);
+    m_running.store(true);
+    m_thread = std::thread(&ResumeLoader::run, this);
+}
+
+void ResumeLoader::stop() {
+    m_cancel.store(true);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void ResumeLoader::run() {
+    auto start = Clock::now();
+    int64_t scanUs = 0;
+    unsigned threads = 0;
+    size_t total = 0;
+
+    if (m_store) {
+        // Records stay mapped (and appends wait) until parsing is done
+        m_store->readAll([&](const std::vector<ResumeStore::RecordView>& records) {
+            std::vector<Source> sources;
+            sources.reserve(records.size());
+            for (const auto& r : records) {
+                sources.push_back({*r.hash, r.data, r.size});
+            }
+            scanUs = elapsedUs(start);
+            total = sources.size();
+            threads = parseSources(sources);
+        });
+    } else {
+        std::vector<Source> sources;
+        std::error_code ec;
+        if (fs::is_directory(m_directory, ec)) {
+            for (const auto& entry : fs::directory_iterator(m_directory, ec)) {
+                if (entry.path().extension() == ".fastresume") {
+                    sources.push_back({entry.path().string(), nullptr, 0});
+                }
+            }
+        }
+        scanUs = elapsedUs(start);
+        total = sources.size();
+        threads = parseSources(sources);
+    }
+
+    int64_t wallUs = elapsedUs(start);
+    std::cout << "Loaded " << m_loaded.load() << "/" << total << " torrents from resume data in "
+              << wallUs / 1000 << " ms on " << threads << " threads (scan " << scanUs / 1000
+              << " ms; read " << m_readUs.load() / 1000 << " ms, parse " << m_parseUs.load() / 1000
+              << " ms, add " << m_addUs.load() / 1000 << " ms summed over threads)";
+    if (m_failed.load() > 0) {
+        std::cout << ", " << m_failed.load() << " failed";
+    }
+    if (m_cancel.load()) {
+        std::cout << ", cancelled";
+    }
+    std::cout << std::endl;
+
+    m_running.store(false);
+}
+
+unsigned ResumeLoader::parseSources(const std::vector<Source>& sources) {
+    if (sources.empty()) {
+        return 0;
+    }
+
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        std::vector<char> buffer;
+        std::vector<lt::add_torrent_params> batch;
+        batch.reserve(BATCH_SIZE);
+
+        while (!m_cancel.load()) {
+            size_t i = next.fetch_add(1);
+            if (i >= sources.size()) {
+                break;
+            }
+            const Source& src = sources[i];
+            const char* data = src.data;
+            size_t size = src.size;
+
+            if (!data) {
+                auto t = Clock::now();
+                bool ok = ResumeStore::readFile(src.path, buffer);
+                m_readUs += elapsedUs(t);
+                if (!ok || buffer.empty()) {
+                    m_failed++;
+                    continue;
+                }
+                data = buffer.data();
+                size = buffer.size();
+            }
+
+            auto t = Clock::now();
+            lt::error_code ec;
+            lt::add_torrent_params params;
+            bool parsed = true;
+            try {
+                params = lt::read_resume_data(lt::span<char const>(data, static_cast<std::ptrdiff_t>(size)), ec);
+            } catch (...) {
+                parsed = false;
+            }
+            m_parseUs += elapsedUs(t);
+
+            if (!parsed || ec) {
+                std::cerr << "Error reading resume data (" << src.path << "): "
+                          << (parsed ? ec.message() : "exception") << std::endl;
+                m_failed++;
+                continue;
+            }
+            params.flags |= lt::torrent_flags::auto_managed;
+            batch.push_back(std::move(params));
+
+            if (batch.size() >= BATCH_SIZE) {
+                submit(batch);
+            }
+        }
+        submit(batch);
+    };
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned threads = static_cast<unsigned>(std::min<size_t>({hw, MAX_THREADS, sources.size()}));
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& w : workers) {
+        w.join();
+    }
+    return threads;
+}
+
+void ResumeLoader::submit(std::vector<lt::add_torrent_params>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    auto t = Clock::now();
+    size_t count = batch.size();
+    if (!m_cancel.load()) {
+        m_add(batch);
+        m_loaded += count;
+    }
+    batch.clear();
+    m_addUs += elapsedUs(t);
+}
@@ -0,0 +1,583 @@
+#include "ResumeStore.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    // "FTRSLOG" + format version
+    const char FILE_MAGIC[8] = {'F', 'T', 'R', 'S', 'L', 'O', 'G', 1};
+
+    uint32_t recordCrc(const char* data, size_t size) {
+        uLong crc = crc32(0L, Z_NULL, 0);
+        return static_cast<uint32_t>(crc32(crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size)));
+    }
+}
+
+ResumeStore::ResumeStore(const std::string& path)
+    : m_path(path)
+    , m_file(nullptr)
+    , m_fileSize(0)
+    , m_liveBytes(0)
+    , m_compactions(0)
+    , m_map(nullptr)
+    , m_mapSize(0)
+#ifdef _WIN32
+    , m_mapFile(nullptr)
+    , m_mapHandle(nullptr)
+#endif
+{
+}
+
+ResumeStore::~ResumeStore() {
+    close();
+}
+
+bool ResumeStore::open() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file) {
+        return true;
+    }
+
+    std::error_code ec;
+    fs::create_directories(fs::path(m_path).parent_path(), ec);
+
+    if (!fs::exists(m_path, ec) && !createEmpty()) {
+        return false;
+    }
+    if (!scan()) {
+        std::cerr << "Resume store has an unknown format, moving it aside: " << m_path << std::endl;
+        fs::rename(m_path, m_path + ".corrupt", ec);
+        if (!createEmpty() || !scan()) {
+            return false;
+        }
+    }
+    if (!openAppend()) {
+        return false;
+    }
+
+    std::cout << "Resume store: " << m_index.size() << " records, "
+              << m_fileSize << " bytes" << std::endl;
+    return true;
+}
+
+void ResumeStore::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    unmapFile();
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    m_index.clear();
+    m_fileSize = 0;
+    m_liveBytes = 0;
+}
+
+size_t ResumeStore::readAll(const Reader& read) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file || !ensureMapped()) {
+        return 0;
+    }
+
+    // Log order, so readers stream through the mapping
+    std::vector<RecordView> records;
+    records.reserve(m_index.size());
+    for (const auto& [key, entry] : entriesInLogOrder()) {
+        records.push_back({key, m_map + entry->offset + entry->payloadOffset, entry->payloadSize});
+    }
+    read(records);
+
+    // Startup is the only reader; don't keep the log mapped afterwards
+    unmapFile();
+    return records.size();
+}
+
+bool ResumeStore::append(const std::vector<Record>& records) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file) {
+        return false;
+    }
+
+    struct Appended {
+        uint8_t type;
+        const std::string* key;
+        Entry entry; // offset relative to the start of buf
+    };
+    std::vector<char> buf;
+    std::vector<Appended> appended;
+    appended.reserve(records.size());
+
+    for (const auto& r : records) {
+        if (r.hash.empty() || r.hash.size() > 255) {
+            std::cerr << "Resume store: invalid key '" << r.hash << "'" << std::endl;
+            continue;
+        }
+        if (r.remove && m_index.find(r.hash) == m_index.end()) {
+            continue;
+        }
+
+        uint64_t start = buf.size();
+        const char* data = (r.remove || !r.data) ? nullptr : r.data->data();
+        size_t size = (r.remove || !r.data) ? 0 : r.data->size();
+        uint8_t type = r.remove ? RECORD_REMOVE : RECORD_PUT;
+        encodeRecord(buf, type, r.hash, data, size);
+
+        Entry entry;
+        entry.offset = start;
+        entry.size = static_cast<uint32_t>(buf.size() - start);
+        entry.payloadOffset = static_cast<uint32_t>(RECORD_HEADER_SIZE + r.hash.size());
+        entry.payloadSize = static_cast<uint32_t>(size);
+        appended.push_back({type, &r.hash, entry});
+    }
+    if (buf.empty()) {
+        return true;
+    }
+
+    bool ok = std::fwrite(buf.data(), 1, buf.size(), m_file) == buf.size();
+    ok = ok && syncFile(m_file);
+    if (!ok) {
+        std::cerr << "Failed to append to resume store: " << m_path << std::endl;
+        // Drop the partial tail so later appends stay readable
+        std::fclose(m_file);
+        m_file = nullptr;
+        std::error_code ec;
+        fs::resize_file(m_path, m_fileSize, ec);
+        openAppend();
+        return false;
+    }
+
+    for (auto& a : appended) {
+        a.entry.offset += m_fileSize;
+        applyRecord(a.type, *a.key, a.entry);
+    }
+    m_fileSize += buf.size();
+    return true;
+}
+
+bool ResumeStore::compactIfNeeded() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file || m_fileSize < COMPACT_MIN_SIZE) {
+        return false;
+    }
+    uint64_t dead = m_fileSize - HEADER_SIZE - m_liveBytes;
+    if (dead <= m_liveBytes) {
+        return false;
+    }
+    return compactLocked();
+}
+
+bool ResumeStore::compact() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return compactLocked();
+}
+
+bool ResumeStore::compactLocked() {
+    if (!m_file || !ensureMapped()) {
+        return false;
+    }
+
+    std::string tmpPath = m_path + ".compact";
+    FILE* out = std::fopen(tmpPath.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Failed to open " << tmpPath << std::endl;
+        return false;
+    }
+
+    // Live records are copied verbatim, so their checksums stay valid
+    auto order = entriesInLogOrder();
+    std::vector<uint64_t> newOffsets;
+    newOffsets.reserve(order.size());
+    uint64_t pos = HEADER_SIZE;
+    bool ok = std::fwrite(FILE_MAGIC, 1, HEADER_SIZE, out) == HEADER_SIZE;
+    for (const auto& [key, entry] : order) {
+        if (!ok) break;
+        ok = std::fwrite(m_map + entry->offset, 1, entry->size, out) == entry->size;
+        newOffsets.push_back(pos);
+        pos += entry->size;
+    }
+    ok = ok && syncFile(out);
+    ok = (std::fclose(out) == 0) && ok;
+
+    std::error_code ec;
+    if (!ok) {
+        std::cerr << "Failed to compact resume store: " << m_path << std::endl;
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+
+    // Nothing may hold the old log open across the rename (Windows)
+    unmapFile();
+    std::fclose(m_file);
+    m_file = nullptr;
+
+    fs::rename(tmpPath, m_path, ec);
+    if (ec) {
+        std::cerr << "Failed to replace resume store: " << ec.message() << std::endl;
+        fs::remove(tmpPath, ec);
+        return openAppend();
+    }
+    syncDirectory();
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i].second->offset = newOffsets[i];
+    }
+    std::cout << "Compacted resume store: " << m_fileSize << " -> " << pos << " bytes" << std::endl;
+    m_fileSize = pos;
+    m_compactions++;
+    return openAppend();
+}
+
+size_t ResumeStore::importDirectory(const std::string& directory, bool removeFiles) {
+    std::error_code ec;
+    if (!fs::is_directory(directory, ec)) {
+        return 0;
+    }
+
+    std::vector<std::pair<std::string, std::vector<char>>> loaded;
+    std::vector<fs::path> files;
+    size_t imported = 0;
+
+    // Appends in chunks so a large directory isn't held in memory at once
+    auto flush = [&]() -> bool {
+        std::vector<Record> records;
+        records.reserve(loaded.size());
+        for (const auto& [hash, data] : loaded) {
+            records.push_back({hash, false, &data});
+        }
+        bool ok = append(records);
+        if (ok) {
+            imported += loaded.size();
+        }
+        loaded.clear();
+        return ok;
+    };
+
+    size_t pendingBytes = 0;
+    bool ok = true;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (entry.path().extension() != ".fastresume") continue;
+
+        std::string hash = entry.path().stem().string();
+        bool known;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            known = m_index.find(hash) != m_index.end();
+        }
+        // Already in the log (an interrupted earlier migration): the log wins
+        if (known) {
+            files.push_back(entry.path());
+            continue;
+        }
+
+        std::vector<char> data;
+        if (!readFile(entry.path().string(), data) || data.empty()) {
+            continue;
+        }
+        pendingBytes += data.size();
+        loaded.emplace_back(std::move(hash), std::move(data));
+        files.push_back(entry.path());
+
+        if (pendingBytes >= 64 * 1024 * 1024) {
+            ok = flush() && ok;
+            pendingBytes = 0;
+        }
+    }
+    ok = flush() && ok;
+
+    if (!ok) {
+        std::cerr << "Resume data migration incomplete, keeping " << directory << std::endl;
+    } else if (removeFiles) {
+        for (const auto& path : files) {
+            fs::remove(path, ec);
+        }
+    }
+    if (imported > 0) {
+        std::cout << "Migrated " << imported << " resume files into " << m_path << std::endl;
+    }
+    return imported;
+}
+
+size_t ResumeStore::exportDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file || !ensureMapped()) {
+        return 0;
+    }
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+
+    size_t exported = 0;
+    for (const auto& [key, entry] : entriesInLogOrder()) {
+        std::string finalPath = directory + "/" + *key + ".fastresume";
+        std::string tmpPath = finalPath + ".tmp";
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(m_map + entry->offset + entry->payloadOffset, entry->payloadSize);
+        out.close();
+        if (!out) {
+            std::cerr << "Failed to export resume data: " << finalPath << std::endl;
+            fs::remove(tmpPath, ec);
+            continue;
+        }
+        fs::rename(tmpPath, finalPath, ec);
+        if (!ec) {
+            exported++;
+        }
+    }
+    unmapFile();
+    return exported;
+}
+
+bool ResumeStore::empty() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.empty();
+}
+
+ResumeStore::Stats ResumeStore::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return Stats{m_fileSize, m_liveBytes, m_index.size(), m_compactions};
+}
+
+bool ResumeStore::readFile(const std::string& path, std::vector<char>& out) {
+    std::ifstream is(path, std::ios::binary | std::ios::ate);
+    if (!is) {
+        return false;
+    }
+    std::streamsize size = is.tellg();
+    if (size < 0) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    is.seekg(0);
+    return static_cast<bool>(is.read(out.data(), size));
+}
+
+bool ResumeStore::createEmpty() {
+    FILE* f = std::fopen(m_path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Failed to create resume store: " << m_path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(FILE_MAGIC, 1, HEADER_SIZE, f) == HEADER_SIZE && syncFile(f);
+    ok = (std::fclose(f) == 0) && ok;
+    if (ok) {
+        syncDirectory();
+    }
+    return ok;
+}
+
+bool ResumeStore::scan() {
+    m_index.clear();
+    m_liveBytes = 0;
+    m_fileSize = 0;
+
+    if (!mapFile()) {
+        return false;
+    }
+    if (m_mapSize < HEADER_SIZE || std::memcmp(m_map, FILE_MAGIC, HEADER_SIZE) != 0) {
+        unmapFile();
+        return false;
+    }
+
+    uint64_t pos = HEADER_SIZE;
+    while (pos + RECORD_HEADER_SIZE <= m_mapSize) {
+        const char* p = m_map + pos;
+        uint32_t crc;
+        uint32_t size;
+        std::memcpy(&crc, p, 4);
+        std::memcpy(&size, p + 4, 4);
+        uint8_t type = static_cast<uint8_t>(p[8]);
+        uint8_t keySize = static_cast<uint8_t>(p[9]);
+
+        uint64_t total = RECORD_HEADER_SIZE + keySize + static_cast<uint64_t>(size);
+        if (pos + total > m_mapSize) break;
+        if (type != RECORD_PUT && type != RECORD_REMOVE) break;
+        if (recordCrc(p + 4, total - 4) != crc) break;
+
+        Entry entry;
+        entry.offset = pos;
+        entry.size = static_cast<uint32_t>(total);
+        entry.payloadOffset = static_cast<uint32_t>(RECORD_HEADER_SIZE + keySize);
+        entry.payloadSize = size;
+        applyRecord(type, std::string(p + RECORD_HEADER_SIZE, keySize), entry);
+        pos += total;
+    }
+    m_fileSize = pos;
+
+    if (pos < m_mapSize) {
+        std::cerr << "Resume store: dropping " << (m_mapSize - pos)
+                  << " bytes of incomplete records" << std::endl;
+        unmapFile();
+        std::error_code ec;
+        fs::resize_file(m_path, pos, ec);
+    }
+    return true;
+}
+
+std::vector<std::pair<const std::string*, ResumeStore::Entry*>> ResumeStore::entriesInLogOrder() {
+    std::vector<std::pair<const std::string*, Entry*>> order;
+    order.reserve(m_index.size());
+    for (auto& [key, entry] : m_index) {
+        order.emplace_back(&key, &entry);
+    }
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        return a.second->offset < b.second->offset;
+    });
+    return order;
+}
+
+void ResumeStore::applyRecord(uint8_t type, const std::string& key, const Entry& entry) {
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_liveBytes -= it->second.size;
+        if (type == RECORD_REMOVE) {
+            m_index.erase(it);
+            return;
+        }
+        it->second = entry;
+        m_liveBytes += entry.size;
+    } else if (type == RECORD_PUT) {
+        m_index.emplace(key, entry);
+        m_liveBytes += entry.size;
+    }
+}
+
+void ResumeStore::encodeRecord(std::vector<char>& out, uint8_t type,
+                               const std::string& key, const char* data, size_t size) {
+    size_t start = out.size();
+    size_t total = RECORD_HEADER_SIZE + key.size() + size;
+    out.resize(start + total);
+
+    char* p = out.data() + start;
+    uint32_t size32 = static_cast<uint32_t>(size);
+    std::memcpy(p + 4, &size32, 4);
+    p[8] = static_cast<char>(type);
+    p[9] = static_cast<char>(key.size());
+    p[10] = 0;
+    p[11] = 0;
+    std::memcpy(p + RECORD_HEADER_SIZE, key.data(), key.size());
+    if (size > 0) {
+        std::memcpy(p + RECORD_HEADER_SIZE + key.size(), data, size);
+    }
+
+    uint32_t crc = recordCrc(p + 4, total - 4);
+    std::memcpy(p, &crc, 4);
+}
+
+bool ResumeStore::openAppend() {
+    m_file = std::fopen(m_path.c_str(), "ab");
+    if (!m_file) {
+        std::cerr << "Failed to open resume store for writing: " << m_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ResumeStore::syncFile(FILE* f) {
+    if (std::fflush(f) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return ::fsync(fileno(f)) == 0;
+#endif
+}
+
+void ResumeStore::syncDirectory() const {
+#ifndef _WIN32
+    std::string dir = fs::path(m_path).parent_path().string();
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#endif
+}
+
+bool ResumeStore::ensureMapped() {
+    if (m_map && m_mapSize == m_fileSize) {
+        return true;
+    }
+    unmapFile();
+    return mapFile() && m_mapSize >= m_fileSize;
+}
+
+bool ResumeStore::mapFile() {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(m_path.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        std::cerr << "Failed to map resume store: " << m_path << std::endl;
+        return false;
+    }
+    m_mapFile = file;
+    m_mapHandle = mapping;
+    m_map = static_cast<const char*>(view);
+    m_mapSize = static_cast<uint64_t>(size.QuadPart);
+    return true;
+#else
+    int fd = ::open(m_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map resume store: " << m_path << std::endl;
+        return false;
+    }
+    ::madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    m_map = static_cast<const char*>(view);
+    m_mapSize = static_cast<uint64_t>(st.st_size);
+    return true;
+#endif
+}
+
+void ResumeStore::unmapFile() {
+    if (!m_map) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_map);
+    CloseHandle(m_mapHandle);
+    CloseHandle(m_mapFile);
+    m_mapHandle = nullptr;
+    m_mapFile = nullptr;
+#else
+    ::munmap(const_cast<char*>(m_map), static_cast<size_t>(m_mapSize));
+#endif
+    m_map = nullptr;
+    m_mapSize = 0;
+}
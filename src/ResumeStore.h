@@ -0,0 +1,129 @@
+#ifndef RESUMESTORE_H
+#define RESUMESTORE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <functional>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+/**
+ * @brief Single-file, append-only store for resume data
+ *
+ * Replaces the one-file-per-torrent layout with a log of checksummed
+ * records. Startup maps the log once and hands each live record to the
+ * caller without copying; saves append a whole batch with a single write
+ * and fsync. Superseded records are dropped by compaction, which rewrites
+ * the live records into a new file and renames it over the log.
+ *
+ * Layout: an 8-byte file header, then records of
+ *   crc32 (4) | payload size (4) | type (1) | key size (1) | reserved (2)
+ *   | key | payload
+ * The CRC covers everything after its own field. Integers are stored in
+ * host byte order. A truncated or corrupt tail (crash mid-append) is cut
+ * off when the log is opened.
+ */
+class ResumeStore {
+public:
+    // A live record inside the mapped log, valid only during readAll()
+    struct RecordView {
+        const std::string* hash;
+        const char* data;
+        size_t size;
+    };
+    using Reader = std::function<void(const std::vector<RecordView>& records)>;
+
+    struct Record {
+        std::string hash;
+        bool remove;
+        const std::vector<char>* data; // unused for removals
+    };
+
+    struct Stats {
+        uint64_t fileBytes;
+        uint64_t liveBytes;
+        size_t records;
+        uint64_t compactions;
+    };
+
+    explicit ResumeStore(const std::string& path);
+    ~ResumeStore();
+
+    // Opens (or creates) the log and indexes the live records
+    bool open();
+    void close();
+    bool isOpen() const { return m_file != nullptr; }
+
+    // Hands every live record, in log order, to read while the log is
+    // mapped. Appends wait until read returns.
+    size_t readAll(const Reader& read);
+
+    // Appends a batch of saves/removals with one write and one fsync
+    bool append(const std::vector<Record>& records);
+
+    // Rewrites the log when superseded records outweigh live ones
+    bool compactIfNeeded();
+    bool compact();
+
+    // Migration from/to the per-file layout (<dir>/<hash>.fastresume).
+    // Import skips hashes already in the log and optionally deletes the
+    // imported files once the log is synced.
+    size_t importDirectory(const std::string& directory, bool removeFiles);
+    size_t exportDirectory(const std::string& directory);
+
+    bool empty() const;
+    Stats getStats() const;
+
+    // Reads a whole file with a single read call
+    static bool readFile(const std::string& path, std::vector<char>& out);
+
+private:
+    struct Entry {
+        uint64_t offset; // start of the record header
+        uint32_t size;   // whole record, header included
+        uint32_t payloadOffset;
+        uint32_t payloadSize;
+    };
+
+    std::string m_path;
+    FILE* m_file;     // append handle
+    uint64_t m_fileSize;
+    uint64_t m_liveBytes;
+    uint64_t m_compactions;
+    std::unordered_map<std::string, Entry> m_index;
+    mutable std::mutex m_mutex;
+
+    // Read-only mapping of the log, created on demand
+    const char* m_map;
+    uint64_t m_mapSize;
+#ifdef _WIN32
+    void* m_mapFile;
+    void* m_mapHandle;
+#endif
+
+    static constexpr uint8_t RECORD_PUT = 1;
+    static constexpr uint8_t RECORD_REMOVE = 2;
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr size_t RECORD_HEADER_SIZE = 12;
+    // Logs smaller than this are never compacted
+    static constexpr uint64_t COMPACT_MIN_SIZE = 4 * 1024 * 1024;
+
+    bool mapFile();
+    void unmapFile();
+    bool ensureMapped();
+    bool createEmpty();
+    bool scan();
+    std::vector<std::pair<const std::string*, Entry*>> entriesInLogOrder();
+    bool openAppend();
+    static bool syncFile(FILE* f);
+    void syncDirectory() const;
+    static void encodeRecord(std::vector<char>& out, uint8_t type,
+                             const std::string& key, const char* data, size_t size);
+    void applyRecord(uint8_t type, const std::string& key, const Entry& entry);
+    bool compactLocked();
+};
+
+#endif // RESUMESTORE_H
@@ -0,0 +1,142 @@
+#include "SessionMetrics.h"
+#include "TorrentItem.h"
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+
+const char* const SessionMetrics::METRIC_NAMES[METRIC_COUNT] = {
+    "net.recv_payload_bytes",
+    "net.sent_payload_bytes",
+    "net.recv_bytes",
+    "net.sent_bytes",
+    "peer.num_peers_connected",
+    "dht.dht_nodes",
+    "disk.queued_disk_jobs",
+    "disk.queued_write_bytes",
+    "disk.num_blocks_read"
+};
+
+SessionMetrics::SessionMetrics()
+    : m_head(0)
+    , m_count(0)
+    , m_serial(0)
+{
+    m_indices.fill(-1);
+
+    // Resolve every tracked metric once; names missing from this
+    // libtorrent build simply stay at -1
+    for (const auto& metric : lt::session_stats_metrics()) {
+        for (int i = 0; i < METRIC_COUNT; ++i) {
+            if (std::strcmp(metric.name, METRIC_NAMES[i]) == 0) {
+                m_indices[i] = metric.value_index;
+            }
+        }
+    }
+}
+
+void SessionMetrics::addSample(lt::span<const std::int64_t> counters) {
+    Sample sample;
+    sample.time = std::chrono::steady_clock::now();
+    for (int i = 0; i < METRIC_COUNT; ++i) {
+        int idx = m_indices[i];
+        sample.values[i] = (idx >= 0 && idx < static_cast<int>(counters.size())) ? counters[idx] : -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_history[m_head] = sample;
+    m_head = (m_head + 1) % HISTORY_SIZE;
+    if (m_count < HISTORY_SIZE) {
+        ++m_count;
+    }
+    ++m_serial;
+}
+
+double SessionMetrics::rateInternal(Metric metric) const {
+    // IMPORTANT: Caller must hold m_mutex
+    if (m_count < 2) {
+        return 0.0;
+    }
+
+    const Sample& last = m_history[(m_head + HISTORY_SIZE - 1) % HISTORY_SIZE];
+    const Sample& prev = m_history[(m_head + HISTORY_SIZE - 2) % HISTORY_SIZE];
+    if (last.values[metric] < 0 || prev.values[metric] < 0) {
+        return 0.0;
+    }
+
+    double seconds = std::chrono::duration<double>(last.time - prev.time).count();
+    if (seconds <= 0.0) {
+        return 0.0;
+    }
+    return (last.values[metric] - prev.values[metric]) / seconds;
+}
+
+int SessionMetrics::getDownloadRate() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(rateInternal(RECV_PAYLOAD_BYTES));
+}
+
+int SessionMetrics::getUploadRate() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(rateInternal(SENT_PAYLOAD_BYTES));
+}
+
+std::int64_t SessionMetrics::getValue(Metric metric) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count == 0) {
+        return -1;
+    }
+    return m_history[(m_head + HISTORY_SIZE - 1) % HISTORY_SIZE].values[metric];
+}
+
+double SessionMetrics::getRate(Metric metric) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return rateInternal(metric);
+}
+
+size_t SessionMetrics::getSampleCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count;
+}
+
+std::uint64_t SessionMetrics::getSampleSerial() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_serial;
+}
+
+std::string SessionMetrics::format() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::ostringstream oss;
+    oss << "Session stats (libtorrent metrics)\n";
+    if (m_count == 0) {
+        oss << "No samples yet\n";
+        return oss.str();
+    }
+
+    const Sample& last = m_history[(m_head + HISTORY_SIZE - 1) % HISTORY_SIZE];
+    auto value = [&](Metric m) -> std::string {
+        return last.values[m] < 0 ? std::string("n/a") : std::to_string(last.values[m]);
+    };
+
+    oss << "Download (payload): " << TorrentItem::formatSpeed(static_cast<int>(rateInternal(RECV_PAYLOAD_BYTES)))
+        << "  total " << TorrentItem::formatSize(std::max<std::int64_t>(0, last.values[RECV_PAYLOAD_BYTES])) << "\n";
+    oss << "Upload (payload):   " << TorrentItem::formatSpeed(static_cast<int>(rateInternal(SENT_PAYLOAD_BYTES)))
+        << "  total " << TorrentItem::formatSize(std::max<std::int64_t>(0, last.values[SENT_PAYLOAD_BYTES])) << "\n";
+    oss << "Download (wire):    " << TorrentItem::formatSpeed(static_cast<int>(rateInternal(RECV_BYTES))) << "\n";
+    oss << "Upload (wire):      " << TorrentItem::formatSpeed(static_cast<int>(rateInternal(SENT_BYTES))) << "\n";
+    oss << "Connected peers:    " << value(PEERS_CONNECTED) << "\n";
+    oss << "DHT nodes:          " << value(DHT_NODES) << "\n";
+    oss << "Disk queue:         " << value(DISK_QUEUED_JOBS) << " jobs, "
+        << TorrentItem::formatSize(std::max<std::int64_t>(0, last.values[DISK_QUEUED_WRITE_BYTES])) << " pending\n";
+
+    // libtorrent 2.0 reads through mmap with no block cache of its own, so
+    // only the read rate is reported
+    oss << "Disk reads:         ";
+    if (last.values[DISK_BLOCKS_READ] >= 0) {
+        oss << std::fixed << std::setprecision(1) << rateInternal(DISK_BLOCKS_READ) << " blocks/s\n";
+    } else {
+        oss << "n/a\n";
+    }
+    return oss.str();
+}
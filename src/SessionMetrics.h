@@ -0,0 +1,81 @@
+#ifndef SESSIONMETRICS_H
+#define SESSIONMETRICS_H
+
+#include <libtorrent/session_stats.hpp>
+#include <libtorrent/span.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace lt = libtorrent;
+
+/**
+ * @brief Session-wide counters and gauges from libtorrent's metrics system
+ *
+ * TorrentSession calls post_session_stats() periodically and feeds every
+ * session_stats_alert to addSample(). Metric indices are resolved once from
+ * session_stats_metrics(); each sample keeps only the tracked values in a
+ * fixed ring buffer, so totals and rates cost O(1) to read.
+ */
+class SessionMetrics {
+public:
+    enum Metric {
+        RECV_PAYLOAD_BYTES = 0, // counter
+        SENT_PAYLOAD_BYTES,     // counter
+        RECV_BYTES,             // counter
+        SENT_BYTES,             // counter
+        PEERS_CONNECTED,        // gauge
+        DHT_NODES,              // gauge
+        DISK_QUEUED_JOBS,       // gauge
+        DISK_QUEUED_WRITE_BYTES,// gauge
+        DISK_BLOCKS_READ,       // counter
+        METRIC_COUNT
+    };
+
+    // Samples kept for rate computation and history (one per stats tick)
+    static constexpr size_t HISTORY_SIZE = 120;
+
+    SessionMetrics();
+
+    // Feed session_stats_alert::counters()
+    void addSample(lt::span<const std::int64_t> counters);
+
+    // Payload rates in bytes/s over the last two samples
+    int getDownloadRate() const;
+    int getUploadRate() const;
+
+    // Latest value of a metric (-1 if libtorrent doesn't provide it)
+    std::int64_t getValue(Metric metric) const;
+    // Per-second rate of a counter over the last two samples
+    double getRate(Metric metric) const;
+    size_t getSampleCount() const;
+    // Bumped by every addSample(), so readers can skip unchanged stats
+    std::uint64_t getSampleSerial() const;
+
+    // Multi-line human readable summary
+    std::string format() const;
+
+private:
+    struct Sample {
+        std::chrono::steady_clock::time_point time;
+        std::array<std::int64_t, METRIC_COUNT> values;
+    };
+
+    static const char* const METRIC_NAMES[METRIC_COUNT];
+
+    // Index into session_stats_alert::counters(), -1 when unavailable
+    std::array<int, METRIC_COUNT> m_indices;
+
+    mutable std::mutex m_mutex;
+    std::array<Sample, HISTORY_SIZE> m_history;
+    size_t m_head;  // slot of the next sample
+    size_t m_count; // valid samples (<= HISTORY_SIZE)
+    std::uint64_t m_serial; // samples added so far
+
+    // Caller must hold m_mutex
+    double rateInternal(Metric metric) const;
+};
+
+#endif // SESSIONMETRICS_H
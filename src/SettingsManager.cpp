@@ -78,9 +78,11 @@ void SettingsManager::setDefaults() {
     setDarkMode(false);
     setRamMode(1); // Normal (Default)
     setIpCensored(false);
+    setUiRefreshInterval(100);
     
     // Advanced
     setUserAgent("FTorrent/0.1.0");
+    setResumeStorage("files");
 }
 
 std::string SettingsManager::getConfigPath() const {
@@ -306,6 +308,14 @@ void SettingsManager::setIpCensored(bool censored) {
     setBool("IpCensored", censored);
 }
 
+int SettingsManager::getUiRefreshInterval() const {
+    return getInt("UiRefreshInterval", 100);
+}
+
+void SettingsManager::setUiRefreshInterval(int ms) {
+    setInt("UiRefreshInterval", ms);
+}
+
 std::string SettingsManager::getUserAgent() const {
     return getString("UserAgent");
 }
@@ -313,3 +323,11 @@ std::string SettingsManager::getUserAgent() const {
 void SettingsManager::setUserAgent(const std::string& agent) {
     setString("UserAgent", agent);
 }
+
+std::string SettingsManager::getResumeStorage() const {
+    return getString("ResumeStorage", "files");
+}
+
+void SettingsManager::setResumeStorage(const std::string& storage) {
+    setString("ResumeStorage", storage);
+}
@@ -81,10 +81,19 @@ public:
     bool getIpCensored() const;
     void setIpCensored(bool censored);
     
+    // Frame budget for repainting the main window while it is visible
+    int getUiRefreshInterval() const; // ms
+    void setUiRefreshInterval(int ms);
+    
     // Advanced settings
     std::string getUserAgent() const;
     void setUserAgent(const std::string& agent);
     
+    // Resume data layout: "files" (one .fastresume per torrent) or "log"
+    // (single append-only store, see ResumeStore)
+    std::string getResumeStorage() const;
+    void setResumeStorage(const std::string& storage);
+    
     // Generic getter/setter for custom values
     std::string getString(const std::string& key, const std::string& defaultValue = "") const;
     void setString(const std::string& key, const std::string& value);
@@ -0,0 +1,439 @@
+#include "TorrentCreator.h"
+#include "TorrentItem.h"
+#include "HashBackend.h"
+#include "PiecePlanner.h"
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/bencode.hpp>
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+#include <deque>
+#include <memory>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+
+namespace lt = libtorrent;
+
+namespace {
+    constexpr int BLOCK_SIZE = 16 * 1024;
+
+    std::filesystem::path toPath(const std::string& utf8) {
+#if defined(__cpp_lib_char8_t)
+        return std::filesystem::path(std::u8string_view((const char8_t*)utf8.c_str(), utf8.length()));
+#else
+        return std::filesystem::u8path(utf8);
+#endif
+    }
+
+    std::string toUtf8(const std::filesystem::path& path) {
+#if defined(__cpp_lib_char8_t)
+        std::u8string u8 = path.u8string();
+        return std::string((const char*)u8.data(), u8.size());
+#else
+        return path.u8string();
+#endif
+    }
+
+    struct PieceBuffer {
+        int piece;
+        int size;
+        std::vector<char> data;
+    };
+
+    // Unbounded hand-off queue; the fixed buffer pool bounds what's in flight
+    class PieceQueue {
+    public:
+        void push(std::unique_ptr<PieceBuffer> buffer) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_items.push_back(std::move(buffer));
+            }
+            m_cv.notify_one();
+        }
+
+        // Blocks until an item is available; nullptr once closed and drained
+        std::unique_ptr<PieceBuffer> pop() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+            if (m_items.empty()) {
+                return nullptr;
+            }
+            auto buffer = std::move(m_items.front());
+            m_items.pop_front();
+            return buffer;
+        }
+
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_cv.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<std::unique_ptr<PieceBuffer>> m_items;
+        bool m_closed = false;
+    };
+
+    // v2 piece-layer entry: the merkle root of one piece of one file
+    struct PieceRoot {
+        bool valid = false;
+        lt::file_index_t file;
+        int pieceInFile = 0;
+        lt::sha256_hash root;
+    };
+
+    int nextPowerOfTwo(int n) {
+        int p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // Root of a tree whose leaves are already padded to a power of two
+    lt::sha256_hash merkleRoot(const HashBackend& backend, std::vector<lt::sha256_hash>& level) {
+        char pair[64];
+        while (level.size() > 1) {
+            for (size_t i = 0; i < level.size() / 2; ++i) {
+                std::memcpy(pair, level[2 * i].data(), 32);
+                std::memcpy(pair + 32, level[2 * i + 1].data(), 32);
+                backend.sha256(pair, sizeof(pair), reinterpret_cast<uint8_t*>(level[i].data()));
+            }
+            level.resize(level.size() / 2);
+        }
+        return level.empty() ? lt::sha256_hash() : level[0];
+    }
+}
+
+TorrentCreator::TorrentCreator()
+    : m_running(false)
+    , m_cancelled(false)
+    , m_succeeded(false)
+    , m_abort(false)
+    , m_piecesDone(0)
+    , m_totalPieces(0)
+    , m_bytesDone(0)
+    , m_totalBytes(0)
+    , m_startTicks(0)
+{
+}
+
+TorrentCreator::~TorrentCreator() {
+    cancel();
+    wait();
+}
+
+bool TorrentCreator::start(const Options& options, const std::string& outputPath) {
+    if (m_running.load()) {
+        return false;
+    }
+    wait();
+    m_cancelled.store(false);
+    m_abort.store(false);
+    m_running.store(true);
+    m_thread = std::thread([this, options, outputPath]() {
+        run(options, outputPath);
+    });
+    return true;
+}
+
+bool TorrentCreator::create(const Options& options, const std::string& outputPath) {
+    if (m_running.load()) {
+        return false;
+    }
+    m_cancelled.store(false);
+    m_abort.store(false);
+    m_running.store(true);
+    return run(options, outputPath);
+}
+
+void TorrentCreator::cancel() {
+    if (m_running.load()) {
+        m_cancelled.store(true);
+        m_abort.store(true);
+    }
+}
+
+void TorrentCreator::wait() {
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+TorrentCreator::Progress TorrentCreator::getProgress() const {
+    Progress p;
+    p.piecesDone = m_piecesDone.load();
+    p.totalPieces = m_totalPieces.load();
+    p.bytesDone = m_bytesDone.load();
+    p.totalBytes = m_totalBytes.load();
+    p.bytesPerSecond = 0.0;
+    p.etaSeconds = -1;
+
+    auto start = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_startTicks.load()));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (p.bytesDone > 0 && seconds > 0.0) {
+        p.bytesPerSecond = p.bytesDone / seconds;
+        p.etaSeconds = static_cast<int>((p.totalBytes - p.bytesDone) / p.bytesPerSecond);
+    }
+    return p;
+}
+
+std::string TorrentCreator::getError() const {
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    return m_error;
+}
+
+std::string TorrentCreator::formatProgress(const Progress& progress) {
+    int percent = progress.totalBytes > 0
+        ? static_cast<int>(progress.bytesDone * 100 / progress.totalBytes) : 0;
+    std::string text = "Hashing " + std::to_string(percent) + "% ("
+        + std::to_string(progress.piecesDone) + "/" + std::to_string(progress.totalPieces) + " pieces)";
+    if (progress.bytesPerSecond > 0.0) {
+        text += " - " + TorrentItem::formatSpeed(static_cast<int>(std::min(progress.bytesPerSecond, 2e9)));
+        text += " - ETA " + TorrentItem::formatETA(progress.etaSeconds);
+    }
+    return text;
+}
+
+bool TorrentCreator::parseFormat(const std::string& name, Format& format) {
+    if (name == "hybrid") format = Format::Hybrid;
+    else if (name == "v1") format = Format::V1Only;
+    else if (name == "v2") format = Format::V2Only;
+    else return false;
+    return true;
+}
+
+void TorrentCreator::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    if (m_error.empty()) {
+        m_error = error;
+    }
+    m_abort.store(true);
+}
+
+bool TorrentCreator::run(const Options& options, const std::string& outputPath) {
+    m_succeeded.store(false);
+    m_piecesDone.store(0);
+    m_totalPieces.store(0);
+    m_bytesDone.store(0);
+    m_totalBytes.store(0);
+    m_startTicks.store(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        m_error.clear();
+    }
+
+    try {
+        const HashBackend* backend = HashBackend::find(options.hashBackend);
+        if (!backend) {
+            throw std::runtime_error("hash backend '" + options.hashBackend + "' is not available on this machine");
+        }
+
+        lt::file_storage storage;
+        lt::add_files(storage, options.source);
+        if (storage.num_files() == 0) {
+            throw std::runtime_error("no files found in " + options.source);
+        }
+
+        lt::create_flags_t flags = {};
+        if (options.canonicalFiles || options.format != Format::V1Only) {
+            flags |= lt::create_torrent::canonical_files;
+        }
+        if (options.format == Format::V1Only) flags |= lt::create_torrent::v1_only;
+        else if (options.format == Format::V2Only) flags |= lt::create_torrent::v2_only;
+
+        int pieceSize = options.pieceSize;
+        if (pieceSize <= 0) {
+            PiecePlanner::Plan plan = PiecePlanner::choose(PiecePlanner::fromStorage(storage),
+                options.format, options.canonicalFiles);
+            pieceSize = plan.pieceSize;
+            std::cout << "Piece size for " << options.source << ": " << PiecePlanner::describe(plan) << std::endl;
+        }
+
+        lt::create_torrent ct(storage, pieceSize, flags);
+        const lt::file_storage& files = ct.files();
+        const bool v1 = !ct.is_v2_only();
+        const bool v2 = !ct.is_v1_only();
+
+        for (const auto& url : options.trackers) {
+            if (!url.empty()) ct.add_tracker(url);
+        }
+        for (const auto& url : options.webSeeds) {
+            if (!url.empty()) ct.add_url_seed(url);
+        }
+        if (options.isPrivate) ct.set_priv(true);
+        ct.set_comment(options.comment.c_str());
+        ct.set_creator(options.creator.c_str());
+
+        // add_files() names files relative to the source's parent directory
+        std::string parent = toUtf8(toPath(options.source).parent_path());
+        if (parent.empty()) parent = ".";
+
+        const int numPieces = ct.num_pieces();
+        const int pieceLength = ct.piece_length();
+        m_totalPieces.store(numPieces);
+        m_totalBytes.store(files.total_size());
+
+        std::vector<lt::sha1_hash> pieceHashes(v1 ? numPieces : 0);
+        std::vector<PieceRoot> pieceRoots(v2 ? numPieces : 0);
+
+        unsigned workers = options.threads > 0 ? options.threads
+            : std::max(1u, std::thread::hardware_concurrency());
+        int readers = std::min(READER_THREADS, numPieces);
+
+        // Workers beyond the buffer count just wait their turn
+        int64_t bufferCount = std::min<int64_t>(static_cast<int64_t>(workers) * BUFFERS_PER_WORKER,
+                                                MAX_BUFFER_BYTES / pieceLength);
+        bufferCount = std::min<int64_t>(std::max<int64_t>(bufferCount, MIN_BUFFERS), numPieces);
+
+        PieceQueue freeBuffers;
+        PieceQueue filled;
+        for (int64_t i = 0; i < bufferCount; ++i) {
+            auto buffer = std::make_unique<PieceBuffer>();
+            buffer->data.resize(pieceLength);
+            freeBuffers.push(std::move(buffer));
+        }
+
+        std::atomic<int> nextPiece(0);
+        auto readLoop = [&]() {
+            std::ifstream in;
+            lt::file_index_t openFile(-1);
+
+            while (!m_abort.load()) {
+                int piece = nextPiece.fetch_add(1);
+                if (piece >= numPieces) break;
+
+                auto buffer = freeBuffers.pop();
+                if (!buffer) break;
+                buffer->piece = piece;
+                buffer->size = files.piece_size(lt::piece_index_t(piece));
+
+                int64_t pos = 0;
+                for (const auto& slice : files.map_block(lt::piece_index_t(piece), 0, buffer->size)) {
+                    char* dst = buffer->data.data() + pos;
+                    pos += slice.size;
+                    if (files.pad_file_at(slice.file_index)) {
+                        std::memset(dst, 0, static_cast<size_t>(slice.size));
+                        continue;
+                    }
+                    if (slice.file_index != openFile) {
+                        in.close();
+                        in.clear();
+                        in.open(toPath(files.file_path(slice.file_index, parent)), std::ios::binary);
+                        openFile = slice.file_index;
+                    }
+                    in.seekg(slice.offset);
+                    if (!in || !in.read(dst, slice.size)) {
+                        setError("failed to read " + files.file_path(slice.file_index, parent));
+                        openFile = lt::file_index_t(-1);
+                        break;
+                    }
+                }
+                filled.push(std::move(buffer));
+            }
+        };
+
+        auto hashLoop = [&]() {
+            std::vector<lt::sha256_hash> leaves;
+            while (auto buffer = filled.pop()) {
+                if (!m_abort.load()) {
+                    const int piece = buffer->piece;
+                    const char* data = buffer->data.data();
+
+                    if (v1) {
+                        backend->sha1(data, buffer->size, reinterpret_cast<uint8_t*>(pieceHashes[piece].data()));
+                    }
+                    if (v2) {
+                        // Canonical layout: every file starts on a piece boundary
+                        lt::file_index_t file = files.file_index_at_piece(lt::piece_index_t(piece));
+                        if (!files.pad_file_at(file) && files.file_size(file) > 0) {
+                            int64_t pieceStart = static_cast<int64_t>(piece) * pieceLength;
+                            int64_t fileStart = files.file_offset(file);
+                            int64_t fileSize = files.file_size(file);
+                            int bytes = static_cast<int>(std::min<int64_t>(pieceLength, fileStart + fileSize - pieceStart));
+                            int blocks = (bytes + BLOCK_SIZE - 1) / BLOCK_SIZE;
+                            // A file smaller than a piece pads its tree to the next
+                            // power of two, any other file to a whole piece
+                            int padded = fileSize < pieceLength
+                                ? nextPowerOfTwo(static_cast<int>((fileSize + BLOCK_SIZE - 1) / BLOCK_SIZE))
+                                : pieceLength / BLOCK_SIZE;
+
+                            leaves.assign(padded, lt::sha256_hash());
+                            for (int b = 0; b < blocks; ++b) {
+                                int len = std::min(BLOCK_SIZE, bytes - b * BLOCK_SIZE);
+                                backend->sha256(data + b * BLOCK_SIZE, len, reinterpret_cast<uint8_t*>(leaves[b].data()));
+                            }
+                            PieceRoot& entry = pieceRoots[piece];
+                            entry.valid = true;
+                            entry.file = file;
+                            entry.pieceInFile = static_cast<int>((pieceStart - fileStart) / pieceLength);
+                            entry.root = merkleRoot(*backend, leaves);
+                        }
+                    }
+                    m_bytesDone += buffer->size;
+                    m_piecesDone++;
+                }
+                freeBuffers.push(std::move(buffer));
+            }
+        };
+
+        std::vector<std::thread> hashThreads;
+        hashThreads.reserve(workers);
+        for (unsigned i = 0; i < workers; ++i) {
+            hashThreads.emplace_back(hashLoop);
+        }
+        std::vector<std::thread> readerThreads;
+        for (int i = 0; i < readers; ++i) {
+            readerThreads.emplace_back(readLoop);
+        }
+        for (auto& t : readerThreads) t.join();
+        filled.close();
+        for (auto& t : hashThreads) t.join();
+
+        if (m_cancelled.load()) {
+            throw std::runtime_error("cancelled");
+        }
+        if (m_abort.load()) {
+            throw std::runtime_error(getError());
+        }
+
+        for (int p = 0; p < numPieces; ++p) {
+            if (v1) {
+                ct.set_hash(lt::piece_index_t(p), pieceHashes[p]);
+            }
+            if (v2 && pieceRoots[p].valid) {
+                ct.set_hash2(pieceRoots[p].file, lt::piece_index_t::diff_type(pieceRoots[p].pieceInFile), pieceRoots[p].root);
+            }
+        }
+
+        lt::entry e = ct.generate();
+        if (!options.origin.empty()) e["source"] = options.origin;
+
+        std::vector<char> torrent;
+        lt::bencode(std::back_inserter(torrent), e);
+
+        std::ofstream out(toPath(outputPath), std::ios_base::binary);
+        if (!out) {
+            throw std::runtime_error("could not open " + outputPath + " for writing");
+        }
+        out.write(torrent.data(), torrent.size());
+        out.close();
+        if (!out) {
+            throw std::runtime_error("could not write " + outputPath);
+        }
+
+        m_succeeded.store(true);
+    } catch (const std::exception& e) {
+        if (!m_cancelled.load()) {
+            setError(e.what());
+            std::cerr << "Torrent creation failed: " << e.what() << std::endl;
+        }
+    }
+
+    m_running.store(false);
+    return m_succeeded.load();
+}
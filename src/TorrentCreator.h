@@ -0,0 +1,116 @@
+#ifndef TORRENTCREATOR_H
+#define TORRENTCREATOR_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Builds .torrent files, hashing pieces on every core
+ *
+ * Reader threads walk the pieces in order and fill buffers from a fixed
+ * pool; hash workers take filled buffers, compute the SHA-1 piece hash
+ * (v1/hybrid) and the SHA-256 piece-layer root (v2/hybrid), and hand the
+ * buffer back. The per-file merkle trees are built from those roots as the
+ * pieces stream past, so every file byte is read exactly once whatever the
+ * format. The hashes are applied to the
+ * lt::create_torrent once all pieces are done and the result is written to
+ * disk.
+ *
+ * start() runs the job on a background thread (the dialog polls
+ * getProgress()); create() runs it on the calling thread (command line).
+ * cancel() may be called from any thread.
+ */
+class TorrentCreator {
+public:
+    // BitTorrent metadata to produce. v2 and hybrid always use canonical
+    // (piece-aligned) files so every file has its own merkle tree.
+    enum class Format {
+        Hybrid,
+        V1Only,
+        V2Only
+    };
+
+    struct Options {
+        std::string source;            // file or directory (UTF-8)
+        int pieceSize = 0;             // bytes, 0 = PiecePlanner picks
+        Format format = Format::Hybrid;
+        bool canonicalFiles = true;
+        bool isPrivate = false;
+        std::vector<std::string> trackers;
+        std::vector<std::string> webSeeds;
+        std::string comment;
+        std::string origin;            // "source" field, optional
+        std::string creator = "fTorrent";
+        unsigned threads = 0;          // hash workers, 0 = one per core
+        std::string hashBackend = "auto";  // see HashBackend::find()
+    };
+
+    struct Progress {
+        int piecesDone;
+        int totalPieces;
+        int64_t bytesDone;
+        int64_t totalBytes;
+        double bytesPerSecond;
+        int etaSeconds;                // -1 while unknown
+    };
+
+    TorrentCreator();
+    ~TorrentCreator();
+
+    TorrentCreator(const TorrentCreator&) = delete;
+    TorrentCreator& operator=(const TorrentCreator&) = delete;
+
+    // Background job; false if one is already running
+    bool start(const Options& options, const std::string& outputPath);
+    // Runs on the calling thread; returns true on success
+    bool create(const Options& options, const std::string& outputPath);
+
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.load(); }
+
+    Progress getProgress() const;
+
+    // Outcome of the last job (valid once it has finished)
+    bool succeeded() const { return m_succeeded.load(); }
+    bool wasCancelled() const { return m_cancelled.load(); }
+    std::string getError() const;
+
+    static std::string formatProgress(const Progress& progress);
+    // "hybrid", "v1" or "v2"; false if the name is unknown
+    static bool parseFormat(const std::string& name, Format& format);
+
+private:
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancelled;
+    std::atomic<bool> m_succeeded;
+    std::atomic<bool> m_abort;      // user cancel or a read error
+
+    std::atomic<int> m_piecesDone;
+    std::atomic<int> m_totalPieces;
+    std::atomic<int64_t> m_bytesDone;
+    std::atomic<int64_t> m_totalBytes;
+    std::atomic<std::chrono::steady_clock::rep> m_startTicks;
+
+    mutable std::mutex m_errorMutex;
+    std::string m_error;
+
+    // Pieces in flight per hash worker, as long as they fit in
+    // MAX_BUFFER_BYTES (large pieces on many cores would not); never fewer
+    // than MIN_BUFFERS, so reading and hashing still overlap
+    static constexpr int BUFFERS_PER_WORKER = 2;
+    static constexpr int64_t MAX_BUFFER_BYTES = 256LL * 1024 * 1024;
+    static constexpr int MIN_BUFFERS = 2;
+    static constexpr int READER_THREADS = 2;
+
+    bool run(const Options& options, const std::string& outputPath);
+    void setError(const std::string& error);
+};
+
+#endif // TORRENTCREATOR_H
@@ -1,18 +1,57 @@
 #include "TorrentDetailsDialog.h"
+#include "NumberFormat.h"
+#include "TorrentManager.h"
 #include <FL/Fl.H>
-#include <sstream>
-#include <iomanip>
+#include <cmath>
 
-TorrentDetailsDialog::TorrentDetailsDialog(TorrentItem* torrent)
+namespace {
+
+// Rows compare at the precision they are shown with, so a peer whose
+// progress moved by 0.001% is not redrawn
+bool sameTracker(const TorrentItem::TrackerInfo& a, const TorrentItem::TrackerInfo& b) {
+    return a.url == b.url && a.tier == b.tier && a.status == b.status
+        && a.peersReturned == b.peersReturned && a.latencyMs == b.latencyMs
+        && a.failureStreak == b.failureStreak && a.message == b.message;
+}
+
+bool samePeer(const TorrentItem::PeerInfo& a, const TorrentItem::PeerInfo& b) {
+    return a.ip == b.ip && a.client == b.client
+        && a.downloadRate == b.downloadRate && a.uploadRate == b.uploadRate
+        && std::lround(a.progress * 1000) == std::lround(b.progress * 1000)
+        && a.flags == b.flags;
+}
+
+bool sameFile(const TorrentItem::FileInfo& a, const TorrentItem::FileInfo& b) {
+    return a.name == b.name && a.size == b.size
+        && std::lround(a.progress * 1000) == std::lround(b.progress * 1000)
+        && a.priority == b.priority;
+}
+
+const char* priorityName(int priority) {
+    if (priority <= 0) return "Skip";
+    if (priority < 4) return "Low";
+    if (priority == 4) return "Normal";
+    return "High";
+}
+
+} // namespace
+
+TorrentDetailsDialog::TorrentDetailsDialog(TorrentManager* manager, const std::string& hash)
     : Fl_Window(600, 500, "Torrent Details")
-    , m_torrent(torrent)
+    , m_manager(manager)
+    , m_hash(hash)
 {
-    if (!m_torrent) {
+    if (!m_manager) {
         return;
     }
     
+    // Peer and file lists are handed over through here
+    m_inbox = std::make_shared<Inbox>();
+    m_inbox->dialog = this;
+    
     // Create tabs
     m_tabs = new Fl_Tabs(10, 10, 580, 430);
+    m_tabs->callback(onTabChanged, this);
     
     createGeneralTab();
     createTrackersTab();
@@ -36,9 +75,10 @@ TorrentDetailsDialog::TorrentDetailsDialog(TorrentItem* torrent)
 TorrentDetailsDialog::~TorrentDetailsDialog() {
     Fl::remove_timeout(updateTimerCallback, this);
     
-    delete m_trackersBuffer;
-    delete m_peersBuffer;
-    delete m_filesBuffer;
+    // Answers still on their way keep the inbox alive and find it detached
+    if (m_inbox) {
+        m_inbox->dialog = nullptr;
+    }
 }
 
 void TorrentDetailsDialog::createGeneralTab() {
@@ -109,11 +149,15 @@ void TorrentDetailsDialog::createTrackersTab() {
     m_trackersTab->hide();
     m_trackersTab->begin();
     
-    m_trackersBuffer = new Fl_Text_Buffer();
-    m_trackersDisplay = new Fl_Text_Display(20, 50, 560, 380);
-    m_trackersDisplay->buffer(m_trackersBuffer);
-    m_trackersDisplay->textfont(FL_COURIER);
-    m_trackersDisplay->textsize(12);
+    m_trackersTable = new DetailsTable(20, 50, 560, 380, {
+        {"URL", 200, FL_ALIGN_LEFT},
+        {"Tier", 35, FL_ALIGN_RIGHT},
+        {"Status", 90, FL_ALIGN_LEFT},
+        {"Peers", 45, FL_ALIGN_RIGHT},
+        {"Latency", 60, FL_ALIGN_RIGHT},
+        {"Fails", 40, FL_ALIGN_RIGHT},
+        {"Message", 200, FL_ALIGN_LEFT},
+    });
     
     m_trackersTab->end();
 }
@@ -123,11 +167,14 @@ void TorrentDetailsDialog::createPeersTab() {
     m_peersTab->hide();
     m_peersTab->begin();
     
-    m_peersBuffer = new Fl_Text_Buffer();
-    m_peersDisplay = new Fl_Text_Display(20, 50, 560, 380);
-    m_peersDisplay->buffer(m_peersBuffer);
-    m_peersDisplay->textfont(FL_COURIER);
-    m_peersDisplay->textsize(11);
+    m_peersTable = new DetailsTable(20, 50, 560, 380, {
+        {"IP", 130, FL_ALIGN_LEFT},
+        {"Client", 150, FL_ALIGN_LEFT},
+        {"Down", 80, FL_ALIGN_RIGHT},
+        {"Up", 80, FL_ALIGN_RIGHT},
+        {"Progress", 60, FL_ALIGN_RIGHT},
+        {"Flags", 50, FL_ALIGN_LEFT},
+    });
     
     m_peersTab->end();
 }
@@ -137,11 +184,12 @@ void TorrentDetailsDialog::createFilesTab() {
     m_filesTab->hide();
     m_filesTab->begin();
     
-    m_filesBuffer = new Fl_Text_Buffer();
-    m_filesDisplay = new Fl_Text_Display(20, 50, 560, 380);
-    m_filesDisplay->buffer(m_filesBuffer);
-    m_filesDisplay->textfont(FL_COURIER);
-    m_filesDisplay->textsize(11);
+    m_filesTable = new DetailsTable(20, 50, 560, 380, {
+        {"Filename", 300, FL_ALIGN_LEFT},
+        {"Size", 80, FL_ALIGN_RIGHT},
+        {"Progress", 70, FL_ALIGN_RIGHT},
+        {"Priority", 90, FL_ALIGN_LEFT},
+    });
     
     m_filesTab->end();
 }
@@ -159,110 +207,168 @@ void TorrentDetailsDialog::createButtons() {
 }
 
 void TorrentDetailsDialog::updateInfo() {
-    if (!m_torrent || !m_torrent->isValid()) {
+    if (!m_manager) {
         return;
     }
     
-    // Update torrent data
-    m_torrent->update();
+    // Keep the snapshot alive while we read from it
+    auto snapshot = m_manager->getSnapshot();
+    int row = snapshot->find(m_hash);
+    if (row < 0) {
+        return; // Removed while the dialog was open
+    }
     
-    // Update tabs
-    updateGeneralInfo();
-    updateTrackers();
-    updatePeers();
-    updateFiles();
+    // Hidden tabs are brought up to date when they are selected
+    Fl_Widget* visible = m_tabs->value();
+    if (visible == m_generalTab) {
+        updateGeneralInfo(snapshot->status(row));
+    } else if (visible == m_trackersTab) {
+        updateTrackers();
+    } else if (visible == m_peersTab) {
+        updatePeers();
+    } else if (visible == m_filesTab) {
+        updateFiles();
+    }
 }
 
-void TorrentDetailsDialog::updateGeneralInfo() {
-    m_nameLabel->copy_label(formatLabel("Name", m_torrent->getName()).c_str());
-    m_sizeLabel->copy_label(formatLabel("Size", m_torrent->formatSize(m_torrent->getTotalSize())).c_str());
-    m_statusLabel->copy_label(formatLabel("Status", m_torrent->getStateString()).c_str());
-    
-    std::ostringstream progress;
-    progress << std::fixed << std::setprecision(2) << (m_torrent->getProgress() * 100.0) << "%";
-    m_downloadedLabel->copy_label(formatLabel("Downloaded", 
-        m_torrent->formatSize(m_torrent->getDownloaded()) + " (" + progress.str() + ")").c_str());
+void TorrentDetailsDialog::updateGeneralInfo(const TorrentItem::Status& status) {
+    NumberFormat::Buffer buf;
+    m_nameLabel->copy_label(formatLabel("Name", status.name).c_str());
+    m_sizeLabel->copy_label(formatLabel("Size", TorrentItem::formatSize(status.totalSize)).c_str());
+    m_statusLabel->copy_label(formatLabel("Status", status.getStateString()).c_str());
+    
+    std::string downloaded(NumberFormat::size(buf, status.downloaded));
+    downloaded += " (";
+    downloaded += NumberFormat::percent(buf, status.progress, 2);
+    downloaded += ")";
+    m_downloadedLabel->copy_label(formatLabel("Downloaded", downloaded).c_str());
     
     m_uploadedLabel->copy_label(formatLabel("Uploaded", 
-        m_torrent->formatSize(m_torrent->getUploaded())).c_str());
+        TorrentItem::formatSize(status.uploaded)).c_str());
     
-    std::ostringstream ratio;
-    ratio << std::fixed << std::setprecision(3) << m_torrent->getRatio();
-    m_ratioLabel->copy_label(formatLabel("Ratio", ratio.str()).c_str());
+    m_ratioLabel->copy_label(formatLabel("Ratio", 
+        std::string(NumberFormat::fixed(buf, status.getRatio(), 3))).c_str());
     
     m_downloadSpeedLabel->copy_label(formatLabel("Download Speed", 
-        m_torrent->formatSpeed(m_torrent->getDownloadRate())).c_str());
+        TorrentItem::formatSpeed(status.downloadRate)).c_str());
     
     m_uploadSpeedLabel->copy_label(formatLabel("Upload Speed", 
-        m_torrent->formatSpeed(m_torrent->getUploadRate())).c_str());
+        TorrentItem::formatSpeed(status.uploadRate)).c_str());
     
     m_peersLabel->copy_label(formatLabel("Connected Peers", 
-        std::to_string(m_torrent->getNumPeers())).c_str());
+        std::to_string(status.numPeers)).c_str());
     
     m_seedsLabel->copy_label(formatLabel("Seeds in Swarm", 
-        std::to_string(m_torrent->getNumSeeds())).c_str());
+        std::to_string(status.numSeeds)).c_str());
     
-    m_etaLabel->copy_label(formatLabel("ETA", m_torrent->getETAString()).c_str());
+    m_etaLabel->copy_label(formatLabel("ETA", status.getETAString()).c_str());
     
-    m_savePathLabel->copy_label(formatLabel("Save Path", m_torrent->getSavePath()).c_str());
+    m_savePathLabel->copy_label(formatLabel("Save Path", status.savePath).c_str());
     
-    m_hashLabel->copy_label(formatLabel("Info Hash", m_torrent->getHash()).c_str());
+    m_hashLabel->copy_label(formatLabel("Info Hash", m_hash).c_str());
 }
 
 void TorrentDetailsDialog::updateTrackers() {
-    auto trackers = m_torrent->getTrackers();
-    std::ostringstream oss;
-    
-    oss << std::left << std::setw(40) << "URL" << " | " 
-        << std::setw(20) << "Status" << "\n";
-    oss << std::string(70, '-') << "\n";
-    
-    for (const auto& t : trackers) {
-        oss << std::left << std::setw(40) << t.url.substr(0, 39) << " | " 
-            << std::setw(20) << t.status << "\n";
+    auto trackers = m_manager->getTrackers(m_hash);
+    m_trackersTable->setRowCount(static_cast<int>(trackers.size()));
+    
+    for (size_t i = 0; i < trackers.size(); i++) {
+        const auto& t = trackers[i];
+        if (i < m_trackers.size() && sameTracker(t, m_trackers[i])) {
+            continue;
+        }
+        int row = static_cast<int>(i);
+        m_trackersTable->setCell(row, 0, t.url);
+        m_trackersTable->setCell(row, 1, std::to_string(t.tier));
+        m_trackersTable->setCell(row, 2, t.status);
+        m_trackersTable->setCell(row, 3, t.peersReturned >= 0 ? std::to_string(t.peersReturned) : "-");
+        m_trackersTable->setCell(row, 4, t.latencyMs >= 0 ? std::to_string(t.latencyMs) + " ms" : "-");
+        m_trackersTable->setCell(row, 5, std::to_string(t.failureStreak));
+        m_trackersTable->setCell(row, 6, t.message);
     }
     
-    m_trackersBuffer->text(oss.str().c_str());
+    m_trackers = std::move(trackers);
 }
 
 void TorrentDetailsDialog::updatePeers() {
-    auto peers = m_torrent->getPeers();
-    std::ostringstream oss;
-    
-    oss << std::left << std::setw(18) << "IP" << " | " 
-        << std::setw(20) << "Client" << " | "
-        << std::setw(10) << "Down" << " | "
-        << std::setw(10) << "Up" << " | "
-        << "Prg" << "\n";
-    oss << std::string(75, '-') << "\n";
-    
-    for (const auto& p : peers) {
-        oss << std::left << std::setw(18) << p.ip << " | " 
-            << std::setw(20) << p.client.substr(0, 19) << " | "
-            << std::setw(10) << TorrentItem::formatSpeed(p.downloadRate) << " | "
-            << std::setw(10) << TorrentItem::formatSpeed(p.uploadRate) << " | "
-            << std::fixed << std::setprecision(1) << (p.progress * 100.0) << "%\n";
+    std::shared_ptr<Inbox> inbox = m_inbox;
+    m_manager->requestPeers(m_hash, [inbox](std::vector<TorrentItem::PeerInfo> peers) {
+        {
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->peers = std::move(peers);
+            inbox->hasPeers = true;
+        }
+        postInbox(inbox);
+    });
+}
+
+void TorrentDetailsDialog::updateFiles() {
+    std::shared_ptr<Inbox> inbox = m_inbox;
+    m_manager->requestFiles(m_hash, [inbox](std::vector<TorrentItem::FileInfo> files) {
+        {
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->files = std::move(files);
+            inbox->hasFiles = true;
+        }
+        postInbox(inbox);
+    });
+}
+
+void TorrentDetailsDialog::showPeers(std::vector<TorrentItem::PeerInfo> peers) {
+    m_peersTable->setRowCount(static_cast<int>(peers.size()));
+    
+    NumberFormat::Buffer buf;
+    for (size_t i = 0; i < peers.size(); i++) {
+        const auto& p = peers[i];
+        if (i < m_peers.size() && samePeer(p, m_peers[i])) {
+            continue;
+        }
+        int row = static_cast<int>(i);
+        m_peersTable->setCell(row, 0, p.ip);
+        m_peersTable->setCell(row, 1, p.client);
+        m_peersTable->setCell(row, 2, NumberFormat::speed(buf, p.downloadRate));
+        m_peersTable->setCell(row, 3, NumberFormat::speed(buf, p.uploadRate));
+        m_peersTable->setCell(row, 4, NumberFormat::percent(buf, p.progress, 1));
+        m_peersTable->setCell(row, 5, p.flags);
     }
     
-    m_peersBuffer->text(oss.str().c_str());
+    m_peers = std::move(peers);
 }
 
-void TorrentDetailsDialog::updateFiles() {
-    auto files = m_torrent->getFiles();
-    std::ostringstream oss;
-    
-    oss << std::left << std::setw(40) << "Filename" << " | " 
-        << std::setw(10) << "Size" << " | "
-        << "Progress" << "\n";
-    oss << std::string(70, '-') << "\n";
-    
-    for (const auto& f : files) {
-        oss << std::left << std::setw(40) << f.name.substr(0, 39) << " | " 
-            << std::setw(10) << TorrentItem::formatSize(f.size) << " | "
-            << std::fixed << std::setprecision(1) << (f.progress * 100.0) << "%\n";
+void TorrentDetailsDialog::showFiles(std::vector<TorrentItem::FileInfo> files) {
+    m_filesTable->setRowCount(static_cast<int>(files.size()));
+    
+    NumberFormat::Buffer buf;
+    for (size_t i = 0; i < files.size(); i++) {
+        const auto& f = files[i];
+        if (i < m_files.size() && sameFile(f, m_files[i])) {
+            continue;
+        }
+        int row = static_cast<int>(i);
+        m_filesTable->setCell(row, 0, f.name);
+        m_filesTable->setCell(row, 1, NumberFormat::size(buf, f.size));
+        m_filesTable->setCell(row, 2, NumberFormat::percent(buf, f.progress, 1));
+        m_filesTable->setCell(row, 3, priorityName(f.priority));
+    }
+    
+    m_files = std::move(files);
+}
+
+void TorrentDetailsDialog::takeInbox() {
+    std::vector<TorrentItem::PeerInfo> peers;
+    std::vector<TorrentItem::FileInfo> files;
+    bool hasPeers, hasFiles;
+    {
+        std::lock_guard<std::mutex> lock(m_inbox->mutex);
+        hasPeers = m_inbox->hasPeers;
+        hasFiles = m_inbox->hasFiles;
+        peers.swap(m_inbox->peers);
+        files.swap(m_inbox->files);
+        m_inbox->hasPeers = m_inbox->hasFiles = false;
     }
     
-    m_filesBuffer->text(oss.str().c_str());
+    if (hasPeers) showPeers(std::move(peers));
+    if (hasFiles) showFiles(std::move(files));
 }
 
 std::string TorrentDetailsDialog::formatLabel(const std::string& label, const std::string& value) {
@@ -288,6 +394,11 @@ void TorrentDetailsDialog::onClose(Fl_Widget* w, void* data) {
     dlg->hide();
 }
 
+void TorrentDetailsDialog::onTabChanged(Fl_Widget* w, void* data) {
+    TorrentDetailsDialog* dlg = (TorrentDetailsDialog*)data;
+    dlg->updateInfo();
+}
+
 void TorrentDetailsDialog::updateTimerCallback(void* data) {
     TorrentDetailsDialog* dlg = (TorrentDetailsDialog*)data;
     
@@ -296,3 +407,25 @@ void TorrentDetailsDialog::updateTimerCallback(void* data) {
         Fl::repeat_timeout(2.0, updateTimerCallback, data);
     }
 }
+
+// Engine thread: one pending awake at a time, like MainWindow's updates
+void TorrentDetailsDialog::postInbox(const std::shared_ptr<Inbox>& inbox) {
+    if (inbox->awakePending.exchange(true)) {
+        return;
+    }
+    auto* ref = new std::shared_ptr<Inbox>(inbox);
+    if (Fl::awake(onInbox, ref) != 0) {
+        // Awake queue full: let the next result retry
+        delete ref;
+        inbox->awakePending.store(false);
+    }
+}
+
+void TorrentDetailsDialog::onInbox(void* data) {
+    std::unique_ptr<std::shared_ptr<Inbox>> ref((std::shared_ptr<Inbox>*)data);
+    Inbox& inbox = **ref;
+    inbox.awakePending.store(false);
+    if (inbox.dialog) {
+        inbox.dialog->takeInbox();
+    }
+}
@@ -5,10 +5,16 @@
 #include <FL/Fl_Tabs.H>
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Box.H>
-#include <FL/Fl_Text_Display.H>
-#include <FL/Fl_Text_Buffer.H>
 #include <FL/Fl_Button.H>
+#include "DetailsTable.h"
 #include "TorrentItem.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+class TorrentManager;
 
 /**
  * @brief Diálogo de detalles de un torrent específico
@@ -21,14 +27,17 @@
  */
 class TorrentDetailsDialog : public Fl_Window {
 public:
-    TorrentDetailsDialog(TorrentItem* torrent);
+    TorrentDetailsDialog(TorrentManager* manager, const std::string& hash);
     ~TorrentDetailsDialog();
     
     void show_modal();
     void updateInfo();
     
 private:
-    TorrentItem* m_torrent;
+    // The dialog never holds a TorrentItem; general info comes from the
+    // manager's status snapshot and the tabs query by hash.
+    TorrentManager* m_manager;
+    std::string m_hash;
     
     // Tabs
     Fl_Tabs* m_tabs;
@@ -51,18 +60,36 @@ private:
     
     // Trackers tab
     Fl_Group* m_trackersTab;
-    Fl_Text_Display* m_trackersDisplay;
-    Fl_Text_Buffer* m_trackersBuffer;
+    DetailsTable* m_trackersTable;
     
     // Peers tab
     Fl_Group* m_peersTab;
-    Fl_Text_Display* m_peersDisplay;
-    Fl_Text_Buffer* m_peersBuffer;
+    DetailsTable* m_peersTable;
     
     // Files tab
     Fl_Group* m_filesTab;
-    Fl_Text_Display* m_filesDisplay;
-    Fl_Text_Buffer* m_filesBuffer;
+    DetailsTable* m_filesTable;
+    
+    // What each table currently shows, so a refresh only rewrites the
+    // rows that changed
+    std::vector<TorrentItem::TrackerInfo> m_trackers;
+    std::vector<TorrentItem::PeerInfo> m_peers;
+    std::vector<TorrentItem::FileInfo> m_files;
+    
+    // Peers and files are requested from the manager and arrive later on
+    // the engine thread. They are parked here and handed to the UI thread
+    // with Fl::awake; pending requests and queued awakes hold a reference,
+    // so the inbox outlives the dialog.
+    struct Inbox {
+        std::mutex mutex;
+        std::vector<TorrentItem::PeerInfo> peers;
+        std::vector<TorrentItem::FileInfo> files;
+        bool hasPeers = false;
+        bool hasFiles = false;
+        std::atomic<bool> awakePending{false};
+        TorrentDetailsDialog* dialog = nullptr; // UI thread only; null once closed
+    };
+    std::shared_ptr<Inbox> m_inbox;
     
     // Buttons
     Fl_Button* m_refreshButton;
@@ -75,16 +102,22 @@ private:
     void createFilesTab();
     void createButtons();
     
-    // Update methods
-    void updateGeneralInfo();
+    // Update methods; only the tab on screen is refreshed
+    void updateGeneralInfo(const TorrentItem::Status& status);
     void updateTrackers();
-    void updatePeers();
-    void updateFiles();
+    void updatePeers();     // requests; showPeers() runs when they arrive
+    void updateFiles();     // requests; showFiles() runs when they arrive
+    void showPeers(std::vector<TorrentItem::PeerInfo> peers);
+    void showFiles(std::vector<TorrentItem::FileInfo> files);
+    void takeInbox();
     
     // Callbacks
     static void onRefresh(Fl_Widget* w, void* data);
     static void onClose(Fl_Widget* w, void* data);
+    static void onTabChanged(Fl_Widget* w, void* data);
     static void updateTimerCallback(void* data);
+    static void postInbox(const std::shared_ptr<Inbox>& inbox);
+    static void onInbox(void* data);
     
     // Helper
     std::string formatLabel(const std::string& label, const std::string& value);
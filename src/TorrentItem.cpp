@@ -1,84 +1,131 @@
 #include "TorrentItem.h"
+#include "TorrentStatusTable.h"
+#include "NumberFormat.h"
+#include "TrackerHealth.h"
 #include <libtorrent/torrent_info.hpp>
 #include <libtorrent/hex.hpp>
-#include <libtorrent/announce_entry.hpp>
 #include <libtorrent/peer_info.hpp>
-#include <sstream>
-#include <iomanip>
 #include <vector>
 
-TorrentItem::TorrentItem(const lt::torrent_handle& handle)
+TorrentItem::TorrentItem(TorrentStatusTable& table, const lt::torrent_handle& handle)
     : m_handle(handle)
-    , m_state(State::Queued)
-    , m_totalSize(0)
-    , m_downloaded(0)
-    , m_uploaded(0)
-    , m_progress(0.0)
-    , m_downloadRate(0)
-    , m_uploadRate(0)
-    , m_numPeers(0)
-    , m_numSeeds(0)
-    , m_addedTime(0)
-    , m_completedTime(0)
+    , m_table(table)
+    , m_slot(table.allocate(Status()))
 {
     if (m_handle.is_valid()) {
+        m_key = keyOf(m_handle.info_hashes());
+        m_hash = toHex(m_key);
         update();
     }
 }
 
+const lt::status_flags_t TorrentItem::STATUS_QUERY_FLAGS =
+    lt::torrent_handle::query_name | lt::torrent_handle::query_save_path;
+
+TorrentItem::TorrentItem(TorrentStatusTable& table, const lt::torrent_handle& handle, const lt::add_torrent_params& params)
+    : m_handle(handle)
+    , m_table(table)
+{
+    m_key = keyOf(m_handle.is_valid() ? m_handle.info_hashes() : params.info_hashes);
+    m_hash = toHex(m_key);
+    m_torrentInfo = params.ti;
+    
+    Status initial;
+    initial.name = params.ti ? params.ti->name() : params.name;
+    initial.savePath = params.save_path;
+    initial.addedTime = params.added_time;
+    initial.completedTime = params.completed_time;
+    if (params.flags & lt::torrent_flags::paused) {
+        initial.state = State::Paused;
+    }
+    m_slot = m_table.allocate(initial);
+}
+
+TorrentItem::~TorrentItem() {
+    m_table.release(m_slot);
+}
+
 void TorrentItem::update() {
     if (!m_handle.is_valid()) {
         return;
     }
 
     try {
-        lt::torrent_status status = m_handle.status();
-        
-        // Basic info
-        m_name = status.name;
-        
-        m_savePath = status.save_path;
-        // libtorrent 2.0 uses info_hashes. v1 is sha1_hash
-        m_hash = toHex(status.info_hashes.v1);
-        
-        // Size info
-        m_totalSize = status.total_wanted;
-        m_downloaded = status.total_wanted_done;
-        m_uploaded = status.total_upload;
-        m_progress = status.progress;
-        
-        // Speed info
-        m_downloadRate = status.download_rate;
-        m_uploadRate = status.upload_rate;
-        
-        // Peer info
-        m_numPeers = status.num_peers;
-        m_numSeeds = status.num_seeds;
-        
-        // State info
-        updateState(status);
-        
-        // If paused, force rates to 0 for UI clarity
-        if (m_state == State::Paused) {
-            m_downloadRate = 0;
-            m_uploadRate = 0;
-            m_numPeers = 0;
-        }
-        
-        // Time info
-        m_addedTime = status.added_time;
-
-        if (status.completed_time > 0) {
-            m_completedTime = status.completed_time;
-        }
+        update(m_handle.status(STATUS_QUERY_FLAGS));
     } catch (const std::exception& e) {
         // Torrent might have been removed or something else went wrong
-        m_state = State::Error;
+        m_table.setState(m_slot, State::Error);
     }
 }
 
-std::string TorrentItem::getStateString() const {
-    switch (m_state) {
+void TorrentItem::update(const lt::torrent_status& status) {
+    m_table.apply(m_slot, status);
+}
+
+TorrentItem::Status TorrentItem::getStatus() const {
+    return m_table.get(m_slot);
+}
+
+std::string TorrentItem::getName() const {
+    auto name = m_table.field(m_slot, &TorrentStatusTable::Columns::name);
+    return name ? *name : std::string();
+}
+
+std::string TorrentItem::getSavePath() const {
+    auto path = m_table.field(m_slot, &TorrentStatusTable::Columns::savePath);
+    return path ? *path : std::string();
+}
+
+TorrentItem::State TorrentItem::getState() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::state);
+}
+
+int64_t TorrentItem::getTotalSize() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::totalSize);
+}
+
+int64_t TorrentItem::getDownloaded() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::downloaded);
+}
+
+int64_t TorrentItem::getUploaded() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::uploaded);
+}
+
+double TorrentItem::getProgress() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::progress);
+}
+
+int TorrentItem::getDownloadRate() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::downloadRate);
+}
+
+int TorrentItem::getUploadRate() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::uploadRate);
+}
+
+int TorrentItem::getNumPeers() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::numPeers);
+}
+
+int TorrentItem::getNumSeeds() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::numSeeds);
+}
+
+int64_t TorrentItem::getAddedTime() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::addedTime);
+}
+
+int64_t TorrentItem::getCompletedTime() const {
+    return m_table.field(m_slot, &TorrentStatusTable::Columns::completedTime);
+}
+
+std::string TorrentItem::stateToString(State state) {
+    return stateName(state);
+}
+
+const char* TorrentItem::stateName(State state) {
+    switch (state) {
         case State::Queued:      return "Queued";
         case State::Checking:    return "Checking";
         case State::Downloading: return "Downloading";
@@ -90,89 +137,61 @@ std::string TorrentItem::getStateString() const {
     }
 }
 
-int TorrentItem::getETA() const {
-    if (m_state != State::Downloading || m_downloadRate <= 0) {
+int TorrentItem::computeETA(State state, int64_t totalSize, int64_t downloaded, int downloadRate) {
+    if (state != State::Downloading || downloadRate <= 0) {
         return -1; // No ETA
     }
     
-    int64_t remaining = m_totalSize - m_downloaded;
+    int64_t remaining = totalSize - downloaded;
     if (remaining <= 0) return 0;
     
-    return static_cast<int>(remaining / m_downloadRate);
+    return static_cast<int>(remaining / downloadRate);
 }
 
-std::string TorrentItem::getETAString() const {
-    int eta = getETA();
-    if (eta < 0) return "∞";
-    if (eta == 0) return "Done";
-    
-    return formatTime(eta);
+double TorrentItem::computeRatio(int64_t uploaded, int64_t downloaded) {
+    if (downloaded <= 0) {
+        return uploaded > 0 ? 999.0 : 0.0;
+    }
+    return static_cast<double>(uploaded) / downloaded;
 }
 
-double TorrentItem::getRatio() const {
-    if (m_downloaded <= 0) {
-        return m_uploaded > 0 ? 999.0 : 0.0;
-    }
-    return static_cast<double>(m_uploaded) / m_downloaded;
+std::string TorrentItem::Status::getStateString() const {
+    return stateToString(state);
+}
+
+int TorrentItem::Status::getETA() const {
+    return computeETA(state, totalSize, downloaded, downloadRate);
+}
+
+std::string TorrentItem::Status::getETAString() const {
+    return formatETA(getETA());
+}
+
+std::string TorrentItem::formatETA(int eta) {
+    NumberFormat::Buffer buf;
+    return std::string(NumberFormat::eta(buf, eta));
+}
+
+double TorrentItem::Status::getRatio() const {
+    return computeRatio(uploaded, downloaded);
 }
 
 std::string TorrentItem::formatSize(int64_t bytes) {
-    const char* units[] = {"B", "KB", "MB", "GB", "TB"};
-    int unit = 0;
-    double size = static_cast<double>(bytes);
-    
-    while (size >= 1024 && unit < 4) {
-        size /= 1024;
-        unit++;
-    }
-    
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(2) << size << " " << units[unit];
-    return oss.str();
+    NumberFormat::Buffer buf;
+    return std::string(NumberFormat::size(buf, bytes));
 }
 
 std::string TorrentItem::formatSpeed(int bytesPerSecond) {
-    if (bytesPerSecond <= 0) return "0 B/s";
-    return formatSize(bytesPerSecond) + "/s";
+    NumberFormat::Buffer buf;
+    return std::string(NumberFormat::speed(buf, bytesPerSecond));
 }
 
 std::string TorrentItem::formatTime(int seconds) {
-    if (seconds < 0) return "∞";
-    
-    int h = seconds / 3600;
-    int m = (seconds % 3600) / 60;
-    int s = seconds % 60;
-    
-    std::ostringstream oss;
-    if (h > 0) {
-        oss << h << "h " << m << "m " << s << "s";
-    } else if (m > 0) {
-        oss << m << "m " << s << "s";
-    } else {
-        oss << s << "s";
-    }
-    
-    return oss.str();
+    NumberFormat::Buffer buf;
+    return std::string(NumberFormat::time(buf, seconds));
 }
 
-void TorrentItem::updateState(const lt::torrent_status& status) {
-    if (status.flags & lt::torrent_flags::paused) {
-        m_state = State::Paused;
-    } else {
-        m_state = convertState(status.state);
-        
-        // If finished but seeding
-        if (m_progress >= 1.0 && m_state == State::Downloading) {
-            m_state = State::Complete;
-        }
-    }
-    
-    if (status.errc) {
-        m_state = State::Error;
-    }
-}
-
-TorrentItem::State TorrentItem::convertState(lt::torrent_status::state_t ltState) const {
+TorrentItem::State TorrentItem::convertState(lt::torrent_status::state_t ltState) {
     switch (ltState) {
         case lt::torrent_status::checking_files:
             return State::Checking;
@@ -200,27 +219,57 @@ std::string TorrentItem::toHex(const lt::sha1_hash& hash) {
     return result;
 }
 
-std::vector<TorrentItem::TrackerInfo> TorrentItem::getTrackers() const {
-    std::vector<TrackerInfo> result;
-    if (!m_handle.is_valid()) return result;
+bool TorrentItem::fromHex(const std::string& hex, lt::sha1_hash& out) {
+    if (hex.size() != static_cast<size_t>(lt::sha1_hash::size()) * 2) {
+        return false;
+    }
 
-    auto trackers = m_handle.trackers();
-    for (const auto& t : trackers) {
-        TrackerInfo info;
-        info.url = t.url;
-        info.status = "Working";
-        info.message = "";
-        result.push_back(info);
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    for (int i = 0; i < lt::sha1_hash::size(); ++i) {
+        int hi = nibble(hex[i * 2]);
+        int lo = nibble(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<std::uint8_t>((hi << 4) | lo);
     }
-    return result;
+    return true;
 }
 
-std::vector<TorrentItem::PeerInfo> TorrentItem::getPeers() const {
-    std::vector<PeerInfo> result;
-    if (!m_handle.is_valid()) return result;
+TorrentItem::Key TorrentItem::keyOf(const lt::info_hash_t& hashes) {
+    // libtorrent 2.0 uses info_hashes. v1 is sha1_hash; v2-only torrents
+    // fall back to the truncated v2 hash so they still get a unique key.
+    return hashes.has_v1() ? hashes.v1 : hashes.get_best();
+}
+
+bool TorrentItem::aliasKeyOf(const lt::info_hash_t& hashes, Key& out) {
+    if (!hashes.has_v1() || !hashes.has_v2()) return false;
+    out = Key(reinterpret_cast<const char*>(hashes.v2.data()));
+    return true;
+}
 
-    std::vector<lt::peer_info> peers;
-    m_handle.get_peer_info(peers);
+void TorrentItem::applyHealth(TrackerInfo& info, const TrackerHealth& health) {
+    TrackerHealth::Entry entry;
+    if (!health.get(info.url, entry)) return;
+
+    info.latencyMs = entry.latencyMs;
+    info.lastSuccess = entry.lastSuccess;
+    info.failureStreak = entry.failureStreak;
+    info.peersReturned = entry.peersReturned;
+    info.demoted = entry.demoted;
+    if (entry.demoted) {
+        info.status = "Demoted";
+        if (info.message.empty()) info.message = entry.lastError;
+    }
+}
+
+std::vector<TorrentItem::PeerInfo> TorrentItem::toPeerInfo(const std::vector<lt::peer_info>& peers) {
+    std::vector<PeerInfo> result;
+    result.reserve(peers.size());
 
     for (const auto& p : peers) {
         PeerInfo info;
@@ -243,29 +292,25 @@ std::vector<TorrentItem::PeerInfo> TorrentItem::getPeers() const {
     return result;
 }
 
-std::vector<TorrentItem::FileInfo> TorrentItem::getFiles() const {
+std::vector<TorrentItem::FileInfo> TorrentItem::toFileInfo(const lt::torrent_info& info,
+                                                          const std::vector<lt::download_priority_t>& priorities,
+                                                          const std::vector<int64_t>& progress) {
     std::vector<FileInfo> result;
-    if (!m_handle.is_valid()) return result;
-
-    auto info = m_handle.torrent_file();
-    if (!info) return result;
-
-    lt::file_storage const& fs = info->files();
-    std::vector<int64_t> file_progress;
-    m_handle.file_progress(file_progress);
-
+    lt::file_storage const& fs = info.files();
+    result.reserve(fs.num_files());
     for (int i = 0; i < fs.num_files(); ++i) {
         FileInfo fi;
         fi.name = fs.file_name(lt::file_index_t(i)).to_string();
         fi.size = fs.file_size(lt::file_index_t(i));
         
-        if (fi.size > 0 && i < (int)file_progress.size()) {
-            fi.progress = (double)file_progress[i] / fi.size;
+        if (fi.size > 0 && i < (int)progress.size()) {
+            fi.progress = (double)progress[i] / fi.size;
         } else {
             fi.progress = 0.0;
         }
         
-        fi.priority = (int)static_cast<std::uint8_t>(m_handle.file_priority(lt::file_index_t(i)));
+        fi.priority = i < (int)priorities.size()
+            ? (int)static_cast<std::uint8_t>(priorities[i]) : 4;
         result.push_back(fi);
     }
     return result;
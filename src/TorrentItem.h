@@ -3,18 +3,25 @@
 
 #include <libtorrent/torrent_handle.hpp>
 #include <libtorrent/torrent_status.hpp>
+#include <libtorrent/add_torrent_params.hpp>
 #include <string>
 #include <cstdint>
-#include <mutex>
+#include <cstring>
 #include <vector>
+#include <memory>
 
 namespace lt = libtorrent;
 
+class TorrentStatusTable;
+class TrackerHealth;
+
 /**
  * @brief Representa un torrent individual con toda su información
  * 
  * Esta clase encapsula el estado y la información de un torrent,
  * proporcionando una interfaz simplificada para acceder a sus datos.
+ * The live status fields are stored in a TorrentStatusTable slot; the item
+ * itself only keeps the handle and the identity of the torrent.
  */
 class TorrentItem {
 public:
@@ -28,51 +35,121 @@ public:
         Complete
     };
 
-    TorrentItem(const lt::torrent_handle& handle);
-    
-    // Update torrent information
+    // Binary identity of a torrent (v1 info-hash, or the truncated v2 hash
+    // for v2-only torrents). Used as the registry key instead of hex strings.
+    using Key = lt::sha1_hash;
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const noexcept {
+            // Info-hashes are already uniformly distributed
+            std::size_t h;
+            std::memcpy(&h, key.data(), sizeof(h));
+            return h;
+        }
+    };
+
+    TorrentItem(TorrentStatusTable& table, const lt::torrent_handle& handle);
+    // Builds an item from an add_torrent_alert without a blocking status()
+    // call; the first state_update_alert fills in the live fields.
+    TorrentItem(TorrentStatusTable& table, const lt::torrent_handle& handle, const lt::add_torrent_params& params);
+    ~TorrentItem();
+    
+    // Owns its table slot
+    TorrentItem(const TorrentItem&) = delete;
+    TorrentItem& operator=(const TorrentItem&) = delete;
+    
+    // Status fields requested from libtorrent. Anything not listed here
+    // (piece bitfields, torrent_info copies...) is skipped to keep status
+    // queries cheap.
+    static const lt::status_flags_t STATUS_QUERY_FLAGS;
+    
+    // Update torrent information (blocking status() round-trip)
     void update();
+    // Apply a status snapshot delivered by libtorrent (e.g. state_update_alert)
+    void update(const lt::torrent_status& status);
+    
+    // Plain copy of one torrent's status fields (one row of the table)
+    struct Status {
+        std::string name;
+        std::string savePath;
+        std::string trackerHost;
+        State state = State::Queued;
+        
+        int64_t totalSize = 0;
+        int64_t downloaded = 0;
+        int64_t uploaded = 0;
+        double progress = 0.0;
+        
+        int downloadRate = 0;
+        int uploadRate = 0;
+        
+        int numPeers = 0;
+        int numSeeds = 0;
+        
+        int64_t addedTime = 0;
+        int64_t completedTime = 0;
+        
+        std::string getStateString() const;
+        int getETA() const; // in seconds, -1 when unknown
+        std::string getETAString() const;
+        double getRatio() const;
+    };
+    
+    Status getStatus() const;
+    uint32_t getSlot() const { return m_slot; }
     
     // Getters - Basic Info
-    std::string getName() const { std::lock_guard<std::mutex> lock(m_mutex); return m_name; }
-    std::string getSavePath() const { std::lock_guard<std::mutex> lock(m_mutex); return m_savePath; }
-    std::string getHash() const { std::lock_guard<std::mutex> lock(m_mutex); return m_hash; }
-    State getState() const { std::lock_guard<std::mutex> lock(m_mutex); return m_state; }
-    std::string getStateString() const; // Implemented in cpp
+    std::string getName() const;
+    std::string getSavePath() const;
+    std::string getHash() const { return m_hash; } // Immutable after construction
+    const Key& getKey() const { return m_key; }
+    State getState() const;
+    std::string getStateString() const { return stateToString(getState()); }
     
     // Getters - Size Info
-    int64_t getTotalSize() const { std::lock_guard<std::mutex> lock(m_mutex); return m_totalSize; }
-    int64_t getDownloaded() const { std::lock_guard<std::mutex> lock(m_mutex); return m_downloaded; }
-    int64_t getUploaded() const { std::lock_guard<std::mutex> lock(m_mutex); return m_uploaded; }
-    double getProgress() const { std::lock_guard<std::mutex> lock(m_mutex); return m_progress; }
+    int64_t getTotalSize() const;
+    int64_t getDownloaded() const;
+    int64_t getUploaded() const;
+    double getProgress() const;
     
     // Getters - Speed Info
-    int getDownloadRate() const { std::lock_guard<std::mutex> lock(m_mutex); return m_downloadRate; }
-    int getUploadRate() const { std::lock_guard<std::mutex> lock(m_mutex); return m_uploadRate; }
+    int getDownloadRate() const;
+    int getUploadRate() const;
     
     // Getters - Peer Info
-    int getNumPeers() const { std::lock_guard<std::mutex> lock(m_mutex); return m_numPeers; }
-    int getNumSeeds() const { std::lock_guard<std::mutex> lock(m_mutex); return m_numSeeds; }
+    int getNumPeers() const;
+    int getNumSeeds() const;
     
     // Getters - Time Info
-    int getETA() const; // in seconds, impl in cpp needs lock? It accesses members, so yes.
-    std::string getETAString() const;
-    int64_t getAddedTime() const { std::lock_guard<std::mutex> lock(m_mutex); return m_addedTime; }
-    int64_t getCompletedTime() const { std::lock_guard<std::mutex> lock(m_mutex); return m_completedTime; }
+    int getETA() const { return getStatus().getETA(); }
+    std::string getETAString() const { return getStatus().getETAString(); }
+    int64_t getAddedTime() const;
+    int64_t getCompletedTime() const;
     
     // Getters - Ratio
-    double getRatio() const;
+    double getRatio() const { return getStatus().getRatio(); }
     
     // Handle access - returns safe handle copy
     lt::torrent_handle getHandle() { return m_handle; } 
     const lt::torrent_handle getHandle() const { return m_handle; }
     bool isValid() const { return m_handle.is_valid(); }
     
+    // File layout as of the add (metadata arrives later for magnets), so the
+    // Files view needs no round trip for it. Callers hold the manager's lock.
+    std::shared_ptr<const lt::torrent_info> getTorrentInfo() const { return m_torrentInfo; }
+    void setTorrentInfo(std::shared_ptr<const lt::torrent_info> info) { m_torrentInfo = std::move(info); }
+    
     // Data structures for detailed info
     struct TrackerInfo {
         std::string url;
+        int tier = 0;
         std::string status;
         std::string message;
+        // From the shared TrackerHealth table (all torrents on this URL)
+        int latencyMs = -1;
+        int64_t lastSuccess = 0;
+        int failureStreak = 0;
+        int peersReturned = -1;
+        bool demoted = false;
     };
     
     struct PeerInfo {
@@ -91,42 +168,46 @@ public:
         int priority;
     };
 
-    std::vector<TrackerInfo> getTrackers() const;
-    std::vector<PeerInfo> getPeers() const;
-    std::vector<FileInfo> getFiles() const;
+    // Fills in the cross-torrent stats TrackerHealth keeps for info.url
+    static void applyHealth(TrackerInfo& info, const TrackerHealth& health);
+    // Peers and files come in through peer_info_alert / file_progress_alert;
+    // these turn the raw alert data into the rows the details view shows
+    static std::vector<PeerInfo> toPeerInfo(const std::vector<lt::peer_info>& peers);
+    static std::vector<FileInfo> toFileInfo(const lt::torrent_info& info,
+                                            const std::vector<lt::download_priority_t>& priorities,
+                                            const std::vector<int64_t>& progress);
 
     // Utility
     static std::string formatSize(int64_t bytes);
     static std::string formatSpeed(int bytesPerSecond);
     static std::string formatTime(int seconds);
+    static std::string formatETA(int eta); // "∞" when unknown, "Done" at 0
     static std::string toHex(const lt::sha1_hash& hash);
+    static bool fromHex(const std::string& hex, lt::sha1_hash& out);
+    static Key keyOf(const lt::info_hash_t& hashes);
+    // A hybrid torrent added from a v2-only magnet was keyed by its
+    // truncated v2 hash until the metadata brought the v1 one; this is that
+    // earlier key. False when the torrent is not hybrid.
+    static bool aliasKeyOf(const lt::info_hash_t& hashes, Key& out);
+    static std::string stateToString(State state);
+    static const char* stateName(State state);      // static storage, no allocation
+    static State convertState(lt::torrent_status::state_t ltState);
+    // Shared by Status and the columnar table
+    static int computeETA(State state, int64_t totalSize, int64_t downloaded, int downloadRate);
+    static double computeRatio(int64_t uploaded, int64_t downloaded);
 
 private:
     lt::torrent_handle m_handle;
-    mutable std::mutex m_mutex;
     
-    // Cached information
-    std::string m_name;
-    std::string m_savePath;
+    // Identity (set once in the constructor)
+    Key m_key;
     std::string m_hash;
-    State m_state;
-    
-    int64_t m_totalSize;
-    int64_t m_downloaded;
-    int64_t m_uploaded;
-    double m_progress;
-    
-    int m_downloadRate;
-    int m_uploadRate;
-    
-    int m_numPeers;
-    int m_numSeeds;
     
-    int64_t m_addedTime;
-    int64_t m_completedTime;
+    std::shared_ptr<const lt::torrent_info> m_torrentInfo;
     
-    void updateState(const lt::torrent_status& status);
-    State convertState(lt::torrent_status::state_t ltState) const;
+    // Status fields live in the table
+    TorrentStatusTable& m_table;
+    uint32_t m_slot;
 };
 
 #endif // TORRENTITEM_H
@@ -1,11 +1,13 @@
 #include "TorrentListWidget.h"
+#include "NumberFormat.h"
 #include <FL/fl_draw.H>
 #include <FL/Fl.H>
 #include <algorithm>
 #include <sstream>
-#include <iomanip>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cmath>
 
 const TorrentListWidget::ColumnInfo TorrentListWidget::COLUMN_INFO[COL_COUNT] = {
     {"Name",        300, FL_ALIGN_LEFT},
@@ -21,16 +23,55 @@ const TorrentListWidget::ColumnInfo TorrentListWidget::COLUMN_INFO[COL_COUNT] =
 
 // Colors are now dynamic
 
+namespace {
+    // The value a cell displays, at display precision: the cell is
+    // re-formatted and redrawn only when this changes. Names are compared
+    // by RowCache::name instead.
+    int64_t cellValue(const TorrentStatusTable::Columns& c, size_t i, int col) {
+        switch (col) {
+            case TorrentListWidget::COL_SIZE:       return c.totalSize[i];
+            case TorrentListWidget::COL_PROGRESS:   return std::llround(c.progress[i] * 1000.0);
+            case TorrentListWidget::COL_STATUS:     return static_cast<int64_t>(c.state[i]);
+            case TorrentListWidget::COL_DOWN_SPEED: return c.downloadRate[i];
+            case TorrentListWidget::COL_UP_SPEED:   return c.uploadRate[i];
+            case TorrentListWidget::COL_ETA:        return c.eta(i);
+            case TorrentListWidget::COL_RATIO:      return std::llround(c.ratio(i) * 100.0);
+            case TorrentListWidget::COL_PEERS:      return (static_cast<int64_t>(c.numPeers[i]) << 32) | static_cast<uint32_t>(c.numSeeds[i]);
+            default:                                return 0;
+        }
+    }
+
+    std::string_view formatCell(NumberFormat::Buffer& buf, const TorrentStatusTable::Columns& c, size_t i, int col) {
+        switch (col) {
+            case TorrentListWidget::COL_NAME:
+                return c.name[i] ? std::string_view(*c.name[i]) : std::string_view();
+            case TorrentListWidget::COL_SIZE:       return NumberFormat::size(buf, c.totalSize[i]);
+            case TorrentListWidget::COL_PROGRESS:   return NumberFormat::percent(buf, c.progress[i], 1);
+            case TorrentListWidget::COL_STATUS:     return TorrentItem::stateName(c.state[i]);
+            case TorrentListWidget::COL_DOWN_SPEED: return NumberFormat::speed(buf, c.downloadRate[i]);
+            case TorrentListWidget::COL_UP_SPEED:   return NumberFormat::speed(buf, c.uploadRate[i]);
+            case TorrentListWidget::COL_ETA:        return NumberFormat::eta(buf, c.eta(i));
+            case TorrentListWidget::COL_RATIO:      return NumberFormat::fixed(buf, c.ratio(i), 2);
+            case TorrentListWidget::COL_PEERS:      return NumberFormat::peers(buf, c.numPeers[i], c.numSeeds[i]);
+            default:                                return std::string_view();
+        }
+    }
+}
+
 TorrentListWidget::TorrentListWidget(int x, int y, int w, int h, const char* label)
     : Fl_Table_Row(x, y, w, h, label)
     , m_sortColumn(COL_NAME)
     , m_sortAscending(true)
+    , m_hasPrimary(false)
+    , m_anchorRow(-1)
+    , m_cursorRow(-1)
+    , m_dragSelecting(false)
     , m_dropHighlight(false)
 {
     initializeColumns();
     
-    // Table settings
-    type(SELECT_MULTI);
+    // Table settings; selection is handled here (see m_selectedKeys)
+    type(SELECT_NONE);
     when(FL_WHEN_RELEASE);
     
     // Modernize scrollbar
@@ -60,160 +101,358 @@ void TorrentListWidget::initializeColumns() {
     row_header(0);
 }
 
-void TorrentListWidget::setTorrents(const std::vector<TorrentItem*>& torrents) {
-    m_torrents = torrents;
-    updateSortedIndices();
-    rows(m_torrents.size());
+void TorrentListWidget::setSnapshot(std::shared_ptr<const TorrentSnapshot> snapshot) {
+    if (!snapshot || snapshot == m_snapshot) {
+        return;
+    }
+    
+    std::shared_ptr<const TorrentSnapshot> previous = std::move(m_snapshot);
+    m_snapshot = std::move(snapshot);
+    // The index is kept current even while no filter is set, so typing a
+    // query never has to build it from scratch
+    m_filterIndex.update(*m_snapshot);
+    m_filterMask.clear();
+    if (!m_filter.empty()) {
+        m_filterMask = m_filterIndex.match(*m_snapshot, m_filter);
+    }
+    updateSortedIndices(previous.get());
+    bool resized = rows() != static_cast<int>(m_sortedIndices.size());
+    rows(m_sortedIndices.size());
+    m_rowCache.resize(m_sortedIndices.size());
+    
+    pruneSelection();
+    
+    // A row that now shows another torrent changes every column, which
+    // also redraws its selection highlight
+    if (resized) {
+        redraw();
+        return;
+    }
+    
+    // Damage only the visible cells whose text changed; rows scrolled out
+    // of view are brought up to date when they are next drawn
+    int topRow, botRow, leftCol, rightCol;
+    visible_cells(topRow, botRow, leftCol, rightCol);
+    for (int row = std::max(0, topRow); row <= botRow && row < rows(); row++) {
+        unsigned changed = refreshRowCache(row);
+        if (changed == 0) continue;
+        int first = 0, last = COL_COUNT - 1;
+        while (!(changed & (1u << first))) first++;
+        while (!(changed & (1u << last))) last--;
+        redraw_range(row, row, first, last);
+    }
+}
+
+void TorrentListWidget::clear() {
+    m_snapshot.reset();
+    m_sortedIndices.clear();
+    m_rowCache.clear();
+    m_selectedKeys.clear();
+    m_hasPrimary = false;
+    m_anchorRow = m_cursorRow = -1;
+    m_filterIndex.clear();
+    m_filterMask.clear();
+    rows(0);
     redraw();
 }
 
-void TorrentListWidget::addTorrent(TorrentItem* torrent) {
-    if (!torrent) return;
+std::vector<int> TorrentListWidget::getSelectedIndices() const {
+    std::vector<int> selected;
+    if (!m_snapshot) return selected;
     
-    m_torrents.push_back(torrent);
-    updateSortedIndices();
-    rows(m_torrents.size());
-    redraw();
+    selected.reserve(m_selectedKeys.size());
+    for (const auto& key : m_selectedKeys) {
+        int idx = m_snapshot->find(key);
+        if (idx >= 0) selected.push_back(idx);
+    }
+    return selected;
 }
 
-void TorrentListWidget::removeTorrent(const std::string& hash) {
-    auto it = std::remove_if(m_torrents.begin(), m_torrents.end(),
-        [&hash](TorrentItem* item) {
-            return item && item->getHash() == hash;
-        });
+int TorrentListWidget::getSelectedIndex() const {
+    if (!m_snapshot || m_selectedKeys.empty()) return -1;
     
-    if (it != m_torrents.end()) {
-        // Clear selection to avoid graphical glitches with indices
-        for (int i = 0; i < rows(); i++) {
-            select_row(i, 0);
-        }
-        
-        m_torrents.erase(it, m_torrents.end());
-        updateSortedIndices();
-        rows(m_torrents.size());
-        redraw();
+    if (m_hasPrimary && m_selectedKeys.count(m_primaryKey)) {
+        int idx = m_snapshot->find(m_primaryKey);
+        if (idx >= 0) return idx;
     }
+    return m_snapshot->find(*m_selectedKeys.begin());
 }
 
-void TorrentListWidget::updateTorrent(TorrentItem* torrent) {
-    // Just redraw, the torrent object is already updated
-    redraw();
+std::vector<std::string> TorrentListWidget::getSelectedHashes() const {
+    std::vector<std::string> hashes;
+    hashes.reserve(m_selectedKeys.size());
+    for (int idx : getSelectedIndices()) {
+        hashes.push_back(m_snapshot->hashes[idx]);
+    }
+    return hashes;
 }
 
-void TorrentListWidget::clear() {
-    m_torrents.clear();
-    m_sortedIndices.clear();
-    rows(0);
+void TorrentListWidget::clearSelection() {
+    if (m_selectedKeys.empty()) return;
+    m_selectedKeys.clear();
+    m_hasPrimary = false;
     redraw();
 }
 
-std::vector<TorrentItem*> TorrentListWidget::getSelectedTorrents() {
-    std::vector<TorrentItem*> selected;
-    
-    for (int i = 0; i < this->rows(); i++) {
-        if (this->row_selected(i)) {
-            TorrentItem* torrent = getTorrentAt(i);
-            if (torrent) {
-                selected.push_back(torrent);
-            }
-        }
+bool TorrentListWidget::isRowSelected(int row) const {
+    if (m_selectedKeys.empty()) return false;
+    int idx = getIndexAt(row);
+    return idx >= 0 && m_selectedKeys.count(m_snapshot->keys[idx]) > 0;
+}
+
+void TorrentListWidget::selectRow(int row) {
+    m_selectedKeys.clear();
+    m_hasPrimary = false;
+    int idx = getIndexAt(row);
+    if (idx < 0) return;
+    m_selectedKeys.insert(m_snapshot->keys[idx]);
+    m_primaryKey = m_snapshot->keys[idx];
+    m_hasPrimary = true;
+}
+
+void TorrentListWidget::toggleRow(int row) {
+    int idx = getIndexAt(row);
+    if (idx < 0) return;
+    const TorrentItem::Key& key = m_snapshot->keys[idx];
+    if (m_selectedKeys.erase(key) == 0) {
+        m_selectedKeys.insert(key);
+        m_primaryKey = key;
+        m_hasPrimary = true;
     }
-    
-    return selected;
 }
 
-TorrentItem* TorrentListWidget::getSelectedTorrent() {
-    for (int i = 0; i < this->rows(); i++) {
-        if (this->row_selected(i)) {
-            return getTorrentAt(i);
-        }
+void TorrentListWidget::selectRange(int from, int to) {
+    // The primary row stays the one the range was started from
+    if (from > to) std::swap(from, to);
+    from = std::max(from, 0);
+    to = std::min(to, rows() - 1);
+    m_selectedKeys.clear();
+    for (int row = from; row <= to; row++) {
+        int idx = getIndexAt(row);
+        if (idx >= 0) m_selectedKeys.insert(m_snapshot->keys[idx]);
     }
-    return nullptr;
 }
 
-bool TorrentListWidget::hasSelection() {
-    for (int i = 0; i < this->rows(); i++) {
-        if (this->row_selected(i)) {
-            return true;
-        }
+void TorrentListWidget::setCursorRow(int row) {
+    m_cursorRow = row;
+    int topRow, botRow, leftCol, rightCol;
+    visible_cells(topRow, botRow, leftCol, rightCol);
+    if (row < topRow) {
+        top_row(row);
+    } else if (row > botRow) {
+        top_row(row - (botRow - topRow));
+    }
+}
+
+bool TorrentListWidget::handleSelectionKey(int key, bool shift) {
+    const int count = rows();
+    if (count == 0) return false;
+    
+    int topRow, botRow, leftCol, rightCol;
+    visible_cells(topRow, botRow, leftCol, rightCol);
+    const int page = std::max(1, botRow - topRow);
+    const bool hasCursor = m_cursorRow >= 0 && m_cursorRow < count;
+    
+    int target;
+    switch (key) {
+        case FL_Up:        target = hasCursor ? m_cursorRow - 1 : 0; break;
+        case FL_Down:      target = hasCursor ? m_cursorRow + 1 : 0; break;
+        case FL_Page_Up:   target = hasCursor ? m_cursorRow - page : 0; break;
+        case FL_Page_Down: target = hasCursor ? m_cursorRow + page : 0; break;
+        case FL_Home:      target = 0; break;
+        case FL_End:       target = count - 1; break;
+        default:           return false;
+    }
+    target = std::clamp(target, 0, count - 1);
+    
+    if (shift && m_anchorRow >= 0 && m_anchorRow < count) {
+        selectRange(m_anchorRow, target);
+    } else {
+        selectRow(target);
+        m_anchorRow = target;
+    }
+    setCursorRow(target);
+    selectionChanged();
+    return true;
+}
+
+void TorrentListWidget::selectionChanged() {
+    // Only the visible rows are drawn again
+    redraw();
+    if (m_onSelectionChanged) m_onSelectionChanged();
+}
+
+void TorrentListWidget::pruneSelection() {
+    // Removed and filtered-out torrents leave the selection
+    for (auto it = m_selectedKeys.begin(); it != m_selectedKeys.end(); ) {
+        int idx = m_snapshot->find(*it);
+        it = (idx < 0 || !isIncluded(idx)) ? m_selectedKeys.erase(it) : std::next(it);
     }
-    return false;
 }
 
 void TorrentListWidget::sortBy(Column column, bool ascending) {
     m_sortColumn = column;
     m_sortAscending = ascending;
-    updateSortedIndices();
+    updateSortedIndices(nullptr);
     redraw();
 }
 
-void TorrentListWidget::updateSortedIndices() {
-    m_sortedIndices.clear();
-    m_sortedIndices.reserve(m_torrents.size());
+void TorrentListWidget::setFilter(const FilterIndex::Query& query) {
+    m_filter = query;
+    if (!m_snapshot) return;
     
-    for (size_t i = 0; i < m_torrents.size(); i++) {
-        m_sortedIndices.push_back(i);
+    m_filterMask.clear();
+    if (!m_filter.empty()) {
+        m_filterMask = m_filterIndex.match(*m_snapshot, m_filter);
     }
-    
-    // Sort indices based on current sort column
-    std::sort(m_sortedIndices.begin(), m_sortedIndices.end(),
-        [this](int a, int b) { return compareTorrents(a, b); });
+    updateSortedIndices(nullptr);
+    rows(m_sortedIndices.size());
+    m_rowCache.resize(m_sortedIndices.size());
+    pruneSelection();
+    redraw();
 }
 
-bool TorrentListWidget::compareTorrents(int idx1, int idx2) const {
-    TorrentItem* t1 = m_torrents[idx1];
-    TorrentItem* t2 = m_torrents[idx2];
-    
-    if (!t1 || !t2) return false;
-    
-    bool result = false;
+void TorrentListWidget::updateSortedIndices(const TorrentSnapshot* previous) {
+    if (!m_snapshot) {
+        m_sortedIndices.clear();
+        return;
+    }
     
+    using Snap = TorrentSnapshot;
     switch (m_sortColumn) {
         case COL_NAME:
-            result = t1->getName() < t2->getName();
-            break;
-        case COL_SIZE:
-            result = t1->getTotalSize() < t2->getTotalSize();
-            break;
-        case COL_PROGRESS:
-            result = t1->getProgress() < t2->getProgress();
+            // Names are shared, so this compares without copying
+            sortIndicesBy(previous, [](const Snap& s, int i) {
+                const auto& name = s.columns.name[i];
+                return name ? std::string_view(*name) : std::string_view();
+            });
             break;
-        case COL_STATUS:
-            result = t1->getState() < t2->getState();
-            break;
-        case COL_DOWN_SPEED:
-            result = t1->getDownloadRate() < t2->getDownloadRate();
-            break;
-        case COL_UP_SPEED:
-            result = t1->getUploadRate() < t2->getUploadRate();
-            break;
-        case COL_ETA:
-            result = t1->getETA() < t2->getETA();
-            break;
-        case COL_RATIO:
-            result = t1->getRatio() < t2->getRatio();
-            break;
-        case COL_PEERS:
-            result = t1->getNumPeers() < t2->getNumPeers();
+        case COL_SIZE:       sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.totalSize[i]; }); break;
+        case COL_PROGRESS:   sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.progress[i]; }); break;
+        case COL_STATUS:     sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.state[i]; }); break;
+        case COL_DOWN_SPEED: sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.downloadRate[i]; }); break;
+        case COL_UP_SPEED:   sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.uploadRate[i]; }); break;
+        case COL_PEERS:      sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.numPeers[i]; }); break;
+        case COL_ETA:        sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.eta(i); }); break;
+        case COL_RATIO:      sortIndicesBy(previous, [](const Snap& s, int i) { return s.columns.ratio(i); }); break;
+        default: {
+            const int n = static_cast<int>(m_snapshot->size());
+            m_sortedIndices.clear();
+            for (int i = 0; i < n; i++) {
+                if (isIncluded(i)) m_sortedIndices.push_back(i);
+            }
             break;
-        default:
-            result = false;
+        }
+    }
+}
+
+template <typename KeyFn>
+void TorrentListWidget::sortIndicesBy(const TorrentSnapshot* previous, KeyFn key) {
+    const TorrentSnapshot& snap = *m_snapshot;
+    const int n = static_cast<int>(snap.size());
+    const bool ascending = m_sortAscending;
+    auto less = [&](int a, int b) {
+        return ascending ? key(snap, a) < key(snap, b) : key(snap, b) < key(snap, a);
+    };
+    
+    // Carry the previous order over to this snapshot's rows. Rows whose key
+    // is unchanged are still in order relative to each other; only the
+    // changed and new ones need placing.
+    // Rows that start matching the filter count as new.
+    std::vector<int> kept;
+    std::vector<int> dirty;
+    if (previous) {
+        const bool sameRows = previous->keys == snap.keys;
+        std::vector<char> seen(n, 0);
+        kept.reserve(m_sortedIndices.size());
+        for (int oldIdx : m_sortedIndices) {
+            int idx = sameRows ? oldIdx : snap.find(previous->keys[oldIdx]);
+            if (idx < 0) continue;  // removed
+            seen[idx] = 1;
+            if (!isIncluded(idx)) continue;  // filtered out
+            if (key(snap, idx) == key(*previous, oldIdx)) {
+                kept.push_back(idx);
+            } else {
+                dirty.push_back(idx);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            if (!seen[i] && isIncluded(i)) dirty.push_back(i);
+        }
+    } else {
+        // No usable previous order (first snapshot, new sort column or filter)
+        for (int i = 0; i < n; i++) {
+            if (isIncluded(i)) dirty.push_back(i);
+        }
     }
     
-    return m_sortAscending ? result : !result;
+    if (dirty.empty()) {
+        m_sortedIndices.swap(kept);
+        return;
+    }
+    const int total = static_cast<int>(kept.size() + dirty.size());
+    if (static_cast<int>(dirty.size()) * INCREMENTAL_SORT_FRACTION > total) {
+        // Too many moves for a merge to pay off; stable so equal keys keep
+        // their previous relative order and rows don't jitter between ticks
+        kept.insert(kept.end(), dirty.begin(), dirty.end());
+        std::stable_sort(kept.begin(), kept.end(), less);
+        m_sortedIndices.swap(kept);
+        return;
+    }
+    
+    // Sort the few changed rows and merge them in; on equal keys rows that
+    // did not change stay first
+    std::stable_sort(dirty.begin(), dirty.end(), less);
+    m_sortedIndices.resize(total);
+    std::merge(kept.begin(), kept.end(), dirty.begin(), dirty.end(), m_sortedIndices.begin(), less);
 }
 
-TorrentItem* TorrentListWidget::getTorrentAt(int row) const {
-    if (row < 0 || row >= (int)m_sortedIndices.size()) {
-        return nullptr;
+int TorrentListWidget::getIndexAt(int row) const {
+    if (!m_snapshot || row < 0 || row >= (int)m_sortedIndices.size()) {
+        return -1;
     }
     
     int idx = m_sortedIndices[row];
-    if (idx < 0 || idx >= (int)m_torrents.size()) {
-        return nullptr;
+    if (idx < 0 || idx >= (int)m_snapshot->size()) {
+        return -1;
+    }
+    
+    return idx;
+}
+
+unsigned TorrentListWidget::refreshRowCache(int row) {
+    int idx = getIndexAt(row);
+    if (idx < 0 || row >= static_cast<int>(m_rowCache.size())) {
+        return 0;
     }
     
-    return m_torrents[idx];
+    RowCache& cache = m_rowCache[row];
+    const TorrentItem::Key& key = m_snapshot->keys[idx];
+    bool sameTorrent = cache.valid && cache.key == key;
+    if (sameTorrent && cache.epoch == m_snapshot->epoch) {
+        return 0;
+    }
+    
+    const TorrentStatusTable::Columns& c = m_snapshot->columns;
+    NumberFormat::Buffer buf;
+    unsigned changed = 0;
+    for (int col = 0; col < COL_COUNT; col++) {
+        if (col == COL_NAME) {
+            if (sameTorrent && cache.name == c.name[idx]) continue;
+            cache.name = c.name[idx];
+        } else {
+            int64_t value = cellValue(c, idx, col);
+            if (sameTorrent && cache.values[col] == value) continue;
+            cache.values[col] = value;
+        }
+        // assign() reuses the cached string's capacity
+        cache.text[col].assign(formatCell(buf, c, idx, col));
+        changed |= 1u << col;
+    }
+    cache.key = key;
+    cache.epoch = m_snapshot->epoch;
+    cache.valid = true;
+    return changed;
 }
 
 void TorrentListWidget::draw_cell(TableContext context, int row, int col,
@@ -260,79 +499,31 @@ void TorrentListWidget::drawHeader(int col, int x, int y, int w, int h) {
 void TorrentListWidget::drawCell(int row, int col, int x, int y, int w, int h) {
     fl_push_clip(x, y, w, h);
     
-    TorrentItem* torrent = getTorrentAt(row);
-    if (!torrent) {
+    int idx = getIndexAt(row);
+    if (idx < 0 || col < 0 || col >= COL_COUNT) {
         fl_pop_clip();
         return;
     }
+    refreshRowCache(row);
+    const std::string& text = m_rowCache[row].text[col];
     
     // Background
     Fl_Color bg_color = getRowColor(row);
     fl_color(bg_color);
     fl_rectf(x, y, w, h);
     
-    // Text color
-    fl_color(getTextColor(row));
-    fl_font(FL_HELVETICA, 12);
-    
-    std::string text;
-    
-    switch (col) {
-        case COL_NAME:
-            text = torrent->getName();
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_LEFT | FL_ALIGN_CLIP);
-            break;
-            
-        case COL_SIZE:
-            text = torrent->formatSize(torrent->getTotalSize());
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_RIGHT | FL_ALIGN_CLIP);
-            break;
-            
-        case COL_PROGRESS:
-            drawProgressBar(torrent->getProgress(), x + 5, y + 5, w - 10, h - 10);
-            break;
-            
-        case COL_STATUS:
-            text = torrent->getStateString();
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_CENTER | FL_ALIGN_CLIP);
-            break;
-            
-        case COL_DOWN_SPEED:
-            text = torrent->formatSpeed(torrent->getDownloadRate());
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_RIGHT | FL_ALIGN_CLIP);
-            break;
-            
-        case COL_UP_SPEED:
-            text = torrent->formatSpeed(torrent->getUploadRate());
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_RIGHT | FL_ALIGN_CLIP);
-            break;
-            
-        case COL_ETA:
-            text = torrent->getETAString();
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_RIGHT | FL_ALIGN_CLIP);
-            break;
-            
-        case COL_RATIO: {
-            std::ostringstream oss;
-            oss << std::fixed << std::setprecision(2) << torrent->getRatio();
-            text = oss.str();
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_RIGHT | FL_ALIGN_CLIP);
-            break;
-        }
-            
-        case COL_PEERS: {
-            std::ostringstream oss;
-            oss << torrent->getNumPeers() << " (" << torrent->getNumSeeds() << ")";
-            text = oss.str();
-            fl_draw(text.c_str(), x + 5, y, w - 10, h, FL_ALIGN_RIGHT | FL_ALIGN_CLIP);
-            break;
-        }
+    if (col == COL_PROGRESS) {
+        drawProgressBar(m_snapshot->columns.progress[idx], text, x + 5, y + 5, w - 10, h - 10);
+    } else {
+        fl_color(getTextColor(row));
+        fl_font(FL_HELVETICA, 12);
+        fl_draw(text.c_str(), x + 5, y, w - 10, h, COLUMN_INFO[col].alignment | FL_ALIGN_CLIP);
     }
     
     fl_pop_clip();
 }
 
-void TorrentListWidget::drawProgressBar(double progress, int x, int y, int w, int h) {
+void TorrentListWidget::drawProgressBar(double progress, const std::string& text, int x, int y, int w, int h) {
     // Background
     fl_color(getProgressBgColor());
     fl_rectf(x, y, w, h);
@@ -349,11 +540,6 @@ void TorrentListWidget::drawProgressBar(double progress, int x, int y, int w, in
     // Text
     fl_color(FL_FOREGROUND_COLOR);
     fl_font(FL_HELVETICA, 10);
-    
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(1) << (progress * 100.0) << "%";
-    std::string text = oss.str();
-    
     fl_draw(text.c_str(), x, y, w, h, FL_ALIGN_CENTER);
 }
 
@@ -435,8 +621,46 @@ int TorrentListWidget::handle(int event) {
     }
     // ─────────────────────────────────────────────────────────────────────
 
+    if (event == FL_KEYBOARD && handleSelectionKey(Fl::event_key(), (Fl::event_state() & FL_SHIFT) != 0)) {
+        return 1;
+    }
+
     int result = Fl_Table_Row::handle(event);
     
+    // Click, Ctrl+click, Shift+click and drag selection. Each edits the
+    // key set for just the rows involved.
+    if (event == FL_PUSH) {
+        int row, col;
+        ResizeFlag resize;
+        if (cursor2rowcol(row, col, resize) == CONTEXT_CELL && row < rows()) {
+            int state = Fl::event_state();
+            if ((state & FL_SHIFT) && m_anchorRow >= 0 && m_anchorRow < rows()) {
+                selectRange(m_anchorRow, row);
+            } else if (state & FL_COMMAND) {
+                toggleRow(row);
+                m_anchorRow = row;
+            } else {
+                selectRow(row);
+                m_anchorRow = row;
+            }
+            m_cursorRow = row;
+            m_dragSelecting = !(state & FL_COMMAND);
+            selectionChanged();
+            result = 1;
+        }
+    } else if (event == FL_DRAG && m_dragSelecting) {
+        int row, col;
+        ResizeFlag resize;
+        if (cursor2rowcol(row, col, resize) == CONTEXT_CELL && row < rows() && row != m_cursorRow) {
+            selectRange(m_anchorRow, row);
+            m_cursorRow = row;
+            selectionChanged();
+        }
+        result = 1;
+    } else if (event == FL_RELEASE) {
+        m_dragSelecting = false;
+    }
+    
     // Handle column header clicks for sorting
     if (event == FL_RELEASE) {
         if (callback_context() == CONTEXT_COL_HEADER) {
@@ -467,9 +691,11 @@ int TorrentListWidget::handle(int event) {
     // Handle double-click on rows
     if (event == FL_PUSH && Fl::event_clicks() > 0) {
         if (callback_context() == CONTEXT_CELL) {
-            TorrentItem* torrent = getSelectedTorrent();
-            if (torrent) {
-                showDetailsDialog(torrent);
+            int idx = getSelectedIndex();
+            if (idx >= 0 && m_onShowDetails) {
+                // Copy: the callback may run a modal loop that swaps the snapshot
+                std::string hash = m_snapshot->hashes[idx];
+                m_onShowDetails(hash);
             }
         }
     }
@@ -477,14 +703,6 @@ int TorrentListWidget::handle(int event) {
     return result;
 }
 
-#include "TorrentDetailsDialog.h"
-
-void TorrentListWidget::showDetailsDialog(TorrentItem* torrent) {
-    TorrentDetailsDialog* dlg = new TorrentDetailsDialog(torrent);
-    dlg->show_modal();
-    delete dlg;
-}
-
 void TorrentListWidget::drawDropOverlay() {
     // Get the inner table area (excludes headers/scrollbars)
     int tx = x(), ty = y(), tw = w(), th = h();
@@ -531,7 +749,7 @@ void TorrentListWidget::draw() {
 }
 
 Fl_Color TorrentListWidget::getRowColor(int row) const {
-    if (const_cast<TorrentListWidget*>(this)->row_selected(row)) return FL_SELECTION_COLOR;
+    if (isRowSelected(row)) return FL_SELECTION_COLOR;
     
     bool darkMode = fl_gray_ramp(0) == FL_BLACK; // Simple check if dark mode is active
     
@@ -548,7 +766,7 @@ Fl_Color TorrentListWidget::getRowColor(int row) const {
 }
 
 Fl_Color TorrentListWidget::getTextColor(int row) const {
-    if (const_cast<TorrentListWidget*>(this)->row_selected(row)) return FL_WHITE;
+    if (isRowSelected(row)) return FL_WHITE;
     return FL_FOREGROUND_COLOR;
 }
 
@@ -5,7 +5,11 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
+#include <unordered_set>
 #include "TorrentItem.h"
+#include "TorrentSnapshot.h"
+#include "FilterIndex.h"
 
 /**
  * @brief Widget de tabla para mostrar la lista de torrents
@@ -39,30 +43,44 @@ public:
     TorrentListWidget(int x, int y, int w, int h, const char* label = nullptr);
     ~TorrentListWidget();
 
-    // Data management
-    void setTorrents(const std::vector<TorrentItem*>& torrents);
-    void addTorrent(TorrentItem* torrent);
-    void removeTorrent(const std::string& hash);
-    void updateTorrent(TorrentItem* torrent);
+    // Data management. The widget only ever reads the published snapshot,
+    // so drawing and sorting take no locks.
+    void setSnapshot(std::shared_ptr<const TorrentSnapshot> snapshot);
     void clear();
     
-    // Selection
-    std::vector<TorrentItem*> getSelectedTorrents();
-    TorrentItem* getSelectedTorrent();
-    bool hasSelection();
+    std::shared_ptr<const TorrentSnapshot> getSnapshot() const { return m_snapshot; }
+    
+    // Selection, as rows of getSnapshot() (-1 when nothing is selected).
+    // Kept as info-hashes, so it survives re-sorting and removals and the
+    // queries below never scan the rows.
+    std::vector<int> getSelectedIndices() const;
+    int getSelectedIndex() const;   // the last clicked row, if still selected
+    std::vector<std::string> getSelectedHashes() const;
+    bool hasSelection() const { return !m_selectedKeys.empty(); }
+    size_t selectionCount() const { return m_selectedKeys.size(); }
+    void clearSelection();
     
     // Sorting
     void sortBy(Column column, bool ascending = true);
     
+    // Filtering: only matching torrents become rows, and sorting and
+    // drawing only ever see those rows
+    void setFilter(const FilterIndex::Query& query);
+    const FilterIndex::Query& getFilter() const { return m_filter; }
+    const FilterIndex& getFilterIndex() const { return m_filterIndex; }
+    
     // Drag-and-drop
     void setOnDropCallback(std::function<void(const std::string&)> cb) { m_onDropCallback = cb; }
     
+    // Details (double-click on a row)
+    void setOnShowDetails(std::function<void(const std::string&)> cb) { m_onShowDetails = cb; }
+    
+    // Set callback for clicks and keys that change the selection
+    void setOnSelectionChanged(std::function<void()> cb) { m_onSelectionChanged = cb; }
+    
     // Context menu
     void showContextMenu();
     
-    // Details
-    void showDetailsDialog(TorrentItem* torrent);
-    
 protected:
     // Fl_Table overrides
     void draw_cell(TableContext context, int row, int col, 
@@ -72,15 +90,47 @@ protected:
     void draw() override;
     
 private:
-    std::vector<TorrentItem*> m_torrents;
+    std::shared_ptr<const TorrentSnapshot> m_snapshot;
     std::vector<int> m_sortedIndices;
     
+    // Formatted cells per display row. A cell is re-formatted only when the
+    // value it shows changes, and only changed visible cells are redrawn.
+    struct RowCache {
+        TorrentItem::Key key;
+        uint64_t epoch = 0;             // snapshot the row was last checked against
+        bool valid = false;
+        int64_t values[COL_COUNT] = {};
+        std::string text[COL_COUNT];
+        // The name string the text came from. Holding it, not just its
+        // address, keeps a later name from reusing that address unnoticed.
+        std::shared_ptr<const std::string> name;
+    };
+    std::vector<RowCache> m_rowCache;
+    
     Column m_sortColumn;
     bool m_sortAscending;
     
+    FilterIndex m_filterIndex;
+    FilterIndex::Query m_filter;
+    std::vector<char> m_filterMask;     // per snapshot row; empty = no filter
+    
+    // The selection is only ever this set: clicks and keys edit it directly
+    // and cells look their row up in it when drawn, so the table's own row
+    // flags are unused and nothing needs remapping when rows move
+    std::unordered_set<TorrentItem::Key, TorrentItem::KeyHash> m_selectedKeys;
+    TorrentItem::Key m_primaryKey;
+    bool m_hasPrimary;
+    // Display rows (not torrents) where the last range started and where
+    // the cursor is; -1 when unset
+    int m_anchorRow;
+    int m_cursorRow;
+    bool m_dragSelecting;
+    
     // Drag-and-drop state
     bool m_dropHighlight;
     std::function<void(const std::string&)> m_onDropCallback;
+    std::function<void(const std::string&)> m_onShowDetails;
+    std::function<void()> m_onSelectionChanged;
     
     // Column info
     struct ColumnInfo {
@@ -93,18 +143,35 @@ private:
     
     // Helper methods
     void initializeColumns();
-    void updateSortedIndices();
-    TorrentItem* getTorrentAt(int row) const;
+    // Re-sorts for the current snapshot; with the snapshot the current order
+    // was built from, only rows whose sort key changed are re-placed
+    void updateSortedIndices(const TorrentSnapshot* previous);
+    int getIndexAt(int row) const;
     int findTorrentRow(const std::string& hash) const;
+    // Selection editing; each costs at most the rows it touches
+    bool isRowSelected(int row) const;
+    void selectRow(int row);            // replaces the selection
+    void toggleRow(int row);
+    void selectRange(int from, int to); // replaces the selection
+    void setCursorRow(int row);         // scrolls it into view
+    bool handleSelectionKey(int key, bool shift);
+    void selectionChanged();
+    void pruneSelection();
+    bool isIncluded(int idx) const { return m_filterMask.empty() || m_filterMask[idx]; }
+    // Brings a row's cache up to date; returns a bitmask of changed columns
+    unsigned refreshRowCache(int row);
     
     // Drawing helpers
     void drawHeader(int col, int x, int y, int w, int h);
     void drawCell(int row, int col, int x, int y, int w, int h);
-    void drawProgressBar(double progress, int x, int y, int w, int h);
+    void drawProgressBar(double progress, const std::string& text, int x, int y, int w, int h);
     void drawDropOverlay();
     
-    // Sorting comparator
-    bool compareTorrents(int idx1, int idx2) const;
+    // Sorting: orders m_sortedIndices by key(snapshot, row)
+    template <typename KeyFn>
+    void sortIndicesBy(const TorrentSnapshot* previous, KeyFn key);
+    // Changed rows above 1/N of the list fall back to a full sort
+    static constexpr int INCREMENTAL_SORT_FRACTION = 4;
     
     // Colors
     static constexpr Fl_Color COLOR_HEADER_BG = FL_LIGHT2;
@@ -3,19 +3,25 @@
 #include <iostream>
 #include <libtorrent/hex.hpp>
 #include <chrono>
-#include <fstream>
 #include <filesystem>
+#include <unordered_set>
 #include "SystemUtils.h"
 
 TorrentManager::TorrentManager()
     : m_initialized(false)
+    , m_snapshot(std::make_shared<const TorrentSnapshot>())
+    , m_snapshotDirty(false)
+    , m_snapshotEpoch(0)
     , m_running(false)
     , m_publicIp("")
     , m_countryCode("")
+    , m_alertsPending(false)
+    , m_refreshRequested(false)
 {
     m_session = std::make_unique<TorrentSession>();
     // Make sure first check happens immediately
     m_lastIpCheck = std::chrono::steady_clock::now() - std::chrono::hours(1);
+    m_lastResumeSave = std::chrono::steady_clock::now();
 }
 
 TorrentManager::~TorrentManager() {
@@ -35,6 +41,21 @@ bool TorrentManager::initialize() {
     m_session->setErrorCallback([this](const std::string& error) {
         notifyError(error);
     });
+    m_session->setStatusUpdateCallback([this](const std::vector<lt::torrent_status>& statuses) {
+        onStatusUpdates(statuses);
+    });
+    m_session->setTorrentAddedCallback([this](const lt::torrent_handle& handle, const lt::add_torrent_params& params) {
+        onTorrentAdded(handle, params);
+    });
+    m_session->setTorrentRemovedCallback([this](const lt::info_hash_t& hashes) {
+        onTorrentRemoved(hashes);
+    });
+    m_session->setPeerInfoCallback([this](const lt::torrent_handle& handle, const std::vector<lt::peer_info>& peers) {
+        onPeerInfo(handle, peers);
+    });
+    m_session->setFileProgressCallback([this](const lt::torrent_handle& handle, const std::vector<std::int64_t>& progress) {
+        onFileProgress(handle, progress);
+    });
 
     m_running.store(true);
     m_initialized.store(true);
@@ -43,7 +64,26 @@ bool TorrentManager::initialize() {
     size_t numThreads = std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
     std::cout << "TorrentManager initialized (using " << numThreads << " CPU cores available)" << std::endl;
     
-    // Load resident torrents (persistence)
+    // One-off reconciliation with whatever the session already holds.
+    // From here on the registry is maintained from add/remove alerts.
+    {
+        std::lock_guard<std::mutex> lock(m_torrentsMutex);
+        reconcileTorrentsInternal();
+    }
+    
+    // From here on alerts are handled on the engine thread. The notify
+    // callback runs on a libtorrent thread, so it only flags and signals.
+    m_session->setAlertNotify([this]() {
+        {
+            std::lock_guard<std::mutex> lock(m_engineMutex);
+            m_alertsPending = true;
+        }
+        m_engineCv.notify_one();
+    });
+    m_engineThread = std::thread(&TorrentManager::engineLoop, this);
+    
+    // Load resident torrents (persistence) in the background, once the
+    // engine is running, so the list fills in while the window is up
     m_session->loadResidentTorrents();
     
     return true;
@@ -54,14 +94,27 @@ void TorrentManager::shutdown() {
         return;
     }
 
-    // Signal shutdown
-    m_running.store(false);
+    // Signal shutdown and wait for the engine thread to finish its pass
+    {
+        std::lock_guard<std::mutex> lock(m_engineMutex);
+        m_running.store(false);
+    }
+    m_engineCv.notify_one();
+    if (m_engineThread.joinable()) {
+        m_engineThread.join();
+    }
+    m_session->setAlertNotify(nullptr);
 
     // Clear torrents
     {
         std::lock_guard<std::mutex> lock(m_torrentsMutex);
+        m_index.clear();
         m_torrents.clear();
     }
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_snapshot = std::make_shared<const TorrentSnapshot>();
+    }
     
     if (m_session) {
         m_session->shutdown();
@@ -101,14 +154,8 @@ bool TorrentManager::addTorrentFile(const std::string& torrentFile, const std::s
         return false;
     }
 
-    bool success = m_session->addTorrentFile(torrentFile, savePath, file_priorities);
-    
-    if (success) {
-        std::lock_guard<std::mutex> lock(m_torrentsMutex);
-        syncTorrentsInternal();
-    }
-
-    return success;
+    // The item is created when the add_torrent_alert comes back
+    return m_session->addTorrentFile(torrentFile, savePath, file_priorities);
 }
 
 bool TorrentManager::addMagnetLink(const std::string& magnetLink, const std::string& savePath) {
@@ -117,40 +164,32 @@ bool TorrentManager::addMagnetLink(const std::string& magnetLink, const std::str
         return false;
     }
 
-    bool success = m_session->addMagnetLink(magnetLink, savePath);
-    
-    if (success) {
-        std::lock_guard<std::mutex> lock(m_torrentsMutex);
-        syncTorrentsInternal();
-    }
-
-    return success;
+    // The item is created when the add_torrent_alert comes back
+    return m_session->addMagnetLink(magnetLink, savePath);
 }
 
 void TorrentManager::removeTorrent(const std::string& hash, bool deleteFiles) {
     std::lock_guard<std::mutex> lock(m_torrentsMutex);
     
-    auto it = std::find_if(m_torrents.begin(), m_torrents.end(),
-        [&hash](const std::unique_ptr<TorrentItem>& item) {
-            return item && item->getHash() == hash;
-        });
-
-    if (it == m_torrents.end()) {
+    TorrentItem* torrent = findTorrentInternal(hash);
+    if (!torrent) {
         return;
     }
 
     // Keep handle for removal
-    lt::torrent_handle handle = (*it)->getHandle();
+    lt::torrent_handle handle = torrent->getHandle();
+    TorrentItem::Key key = torrent->getKey();
     
     // Remove from session
     m_session->removeTorrent(handle, deleteFiles);
-    m_session->removeResumeData(hash);
+    m_session->removeResumeData(handle, hash);
     
     // Notify before erasing while pointer is still valid
     notifyTorrentRemoved(hash);
 
     // Remove from our list (this deletes the object)
-    m_torrents.erase(it);
+    eraseTorrentInternal(key);
+    m_snapshotDirty.store(true);
 }
 
 void TorrentManager::pauseTorrent(const std::string& hash) {
@@ -159,8 +198,8 @@ void TorrentManager::pauseTorrent(const std::string& hash) {
     auto* torrent = findTorrentInternal(hash);
     if (torrent) {
         m_session->pauseTorrent(torrent->getHandle());
-        torrent->update();
     }
+    requestRefresh();
 }
 
 void TorrentManager::resumeTorrent(const std::string& hash) {
@@ -169,17 +208,18 @@ void TorrentManager::resumeTorrent(const std::string& hash) {
     auto* torrent = findTorrentInternal(hash);
     if (torrent) {
         m_session->resumeTorrent(torrent->getHandle());
-        torrent->update();
     }
+    requestRefresh();
 }
 
 void TorrentManager::pauseAll() {
     std::lock_guard<std::mutex> lock(m_torrentsMutex);
     
+    // The new state arrives with the next state_update_alert
     for (auto& torrent : m_torrents) {
         m_session->pauseTorrent(torrent->getHandle());
-        torrent->update();
     }
+    requestRefresh();
 }
 
 void TorrentManager::resumeAll() {
@@ -187,8 +227,8 @@ void TorrentManager::resumeAll() {
     
     for (auto& torrent : m_torrents) {
         m_session->resumeTorrent(torrent->getHandle());
-        torrent->update();
     }
+    requestRefresh();
 }
 
 void TorrentManager::setRateLimits(int downloadKBps, int uploadKBps) {
@@ -242,6 +282,54 @@ int TorrentManager::getTorrentCount() const {
     return static_cast<int>(m_torrents.size());
 }
 
+std::vector<TorrentItem::TrackerInfo> TorrentManager::getTrackers(const std::string& hash) const {
+    if (!m_session) return {};
+    return m_session->getTrackers(findHandle(hash));
+}
+
+// post_peer_info() and post_file_progress() return immediately; the
+// answers come back as alerts on the engine thread
+bool TorrentManager::requestPeers(const std::string& hash, PeersCallback callback) {
+    lt::torrent_handle handle = findHandle(hash);
+    if (!handle.is_valid()) {
+        return false;
+    }
+    bool post;
+    {
+        std::lock_guard<std::mutex> lock(m_requestsMutex);
+        DetailsRequests& requests = m_requests[TorrentItem::keyOf(handle.info_hashes())];
+        auto now = std::chrono::steady_clock::now();
+        post = requests.peers.empty() || now - requests.peersPosted > DETAILS_REQUEST_TIMEOUT;
+        if (post) requests.peersPosted = now;
+        requests.peers.push_back(std::move(callback));
+    }
+    if (post) {
+        handle.post_peer_info();
+    }
+    return true;
+}
+
+bool TorrentManager::requestFiles(const std::string& hash, FilesCallback callback) {
+    lt::torrent_handle handle = findHandle(hash);
+    if (!handle.is_valid()) {
+        return false;
+    }
+    bool post;
+    {
+        std::lock_guard<std::mutex> lock(m_requestsMutex);
+        DetailsRequests& requests = m_requests[TorrentItem::keyOf(handle.info_hashes())];
+        auto now = std::chrono::steady_clock::now();
+        post = requests.files.empty() || now - requests.filesPosted > DETAILS_REQUEST_TIMEOUT;
+        if (post) requests.filesPosted = now;
+        requests.files.push_back(std::move(callback));
+    }
+    if (post) {
+        handle.post_file_progress({});
+    }
+    return true;
+}
+
+// Session totals come from libtorrent's metrics, not per-torrent sums
 int TorrentManager::getTotalDownloadRate() const {
     if (!m_initialized.load()) {
         return 0;
@@ -256,14 +344,29 @@ int TorrentManager::getTotalUploadRate() const {
     return m_session->getUploadRate();
 }
 
+int TorrentManager::getConnectedPeers() const {
+    if (!m_initialized.load()) {
+        return 0;
+    }
+    return static_cast<int>(m_session->getMetrics().getValue(SessionMetrics::PEERS_CONNECTED));
+}
+
+int TorrentManager::getDhtNodes() const {
+    if (!m_initialized.load()) {
+        return 0;
+    }
+    return static_cast<int>(m_session->getMetrics().getValue(SessionMetrics::DHT_NODES));
+}
+
 int TorrentManager::getActiveTorrentsCount() const {
-    std::lock_guard<std::mutex> lock(m_torrentsMutex);
-    return std::count_if(m_torrents.begin(), m_torrents.end(),
-        [](const std::unique_ptr<TorrentItem>& item) {
-            auto state = item->getState();
-            return state == TorrentItem::State::Downloading || 
-                   state == TorrentItem::State::Seeding;
-        });
+    return getSnapshot()->activeCount;
+}
+
+std::vector<AnnounceScheduler::QueueDepth> TorrentManager::getAnnounceQueueDepths() const {
+    if (!m_initialized.load()) {
+        return {};
+    }
+    return m_session->getAnnounceQueueDepths();
 }
 
 std::string TorrentManager::getSessionStats() const {
@@ -273,6 +376,13 @@ std::string TorrentManager::getSessionStats() const {
     return m_session->getSessionStats();
 }
 
+std::uint64_t TorrentManager::getSessionStatsSerial() const {
+    if (!m_initialized.load()) {
+        return 0;
+    }
+    return m_session->getSessionStatsSerial();
+}
+
 std::string TorrentManager::getPublicIp() const {
     std::lock_guard<std::mutex> lock(m_ipMutex);
     return m_publicIp;
@@ -283,30 +393,75 @@ std::string TorrentManager::getCountryCode() const {
     return m_countryCode;
 }
 
-void TorrentManager::update() {
-    if (!m_initialized.load()) {
-        return;
+void TorrentManager::requestRefresh() {
+    m_refreshRequested.store(true);
+    wakeEngine();
+}
+
+void TorrentManager::wakeEngine() {
+    {
+        // Pairs with the predicate check in engineLoop(), so a flag set just
+        // before the engine starts waiting is not missed
+        std::lock_guard<std::mutex> lock(m_engineMutex);
     }
+    m_engineCv.notify_one();
+}
 
-    // Process alerts from libtorrent
-    m_session->processAlerts();
+void TorrentManager::engineLoop() {
+    auto nextTick = std::chrono::steady_clock::now();
 
-    // Sync and update torrents
-    {
-        std::lock_guard<std::mutex> lock(m_torrentsMutex);
-        
-        // Sync with libtorrent session
-        syncTorrentsInternal();
-        
-        // Update all torrent items
-        for (auto& torrent : m_torrents) {
-            torrent->update();
-            notifyTorrentUpdated(torrent.get());
+    while (m_running.load()) {
+        {
+            std::unique_lock<std::mutex> lock(m_engineMutex);
+            m_engineCv.wait_until(lock, nextTick, [this]() {
+                return m_alertsPending || m_refreshRequested.load() || !m_running.load();
+            });
+            m_alertsPending = false;
+        }
+        if (!m_running.load()) {
+            break;
+        }
+
+        // Drain everything libtorrent has posted: add/remove events, status
+        // deltas, resume data, session stats...
+        m_session->processAlerts();
+
+        auto now = std::chrono::steady_clock::now();
+        bool tick = now >= nextTick;
+        if (tick) {
+            runPeriodicTasks(now);
+            nextTick = now + ENGINE_TICK;
+        } else if (m_refreshRequested.exchange(false)) {
+            m_session->postTorrentUpdates();
+        }
+
+        // Publish the statuses applied in this pass, then tell the UI once
+        bool published = m_snapshotDirty.exchange(false);
+        if (published) {
+            publishSnapshot();
+        }
+        if (published || tick) {
+            notifyStatsUpdated();
         }
     }
+}
+
+void TorrentManager::runPeriodicTasks(std::chrono::steady_clock::time_point now) {
+    // Request the next batch of status deltas: one round-trip for all
+    // torrents instead of a blocking status() call per torrent.
+    m_refreshRequested.store(false);
+    m_session->postTorrentUpdates();
+
+    // Torrent starts and tracker requests whose turn has come
+    m_session->releaseAnnounces();
+
+    // Session counters (every second); the alert is handled next pass
+    if (now - m_lastStatsPost >= std::chrono::seconds(1)) {
+        m_lastStatsPost = now;
+        m_session->postSessionStats();
+    }
 
     // IP Address Check (every 15 minutes)
-    auto now = std::chrono::steady_clock::now();
     if (std::chrono::duration_cast<std::chrono::minutes>(now - m_lastIpCheck).count() >= 15) {
         m_lastIpCheck = now;
         SystemUtils::fetchPublicIpAndCountry([this](std::string ip, std::string country) {
@@ -320,21 +475,10 @@ void TorrentManager::update() {
     }
 
     // Periodic resume data saving (every 30 seconds)
-    static auto lastSave = std::chrono::steady_clock::now();
-    if (std::chrono::steady_clock::now() - lastSave > std::chrono::seconds(30)) {
+    if (now - m_lastResumeSave > std::chrono::seconds(30)) {
         m_session->triggerSaveResumeData();
-        lastSave = std::chrono::steady_clock::now();
+        m_lastResumeSave = now;
     }
-
-    // Notify UI about updates (outside lock to prevent deadlock)
-    notifyStatsUpdated();
-}
-
-void TorrentManager::processAlerts() {
-    if (!m_initialized.load()) {
-        return;
-    }
-    m_session->processAlerts();
 }
 
 // Callback setters (thread-safe)
@@ -367,7 +511,114 @@ void TorrentManager::setOnError(ErrorCallback callback) {
 // PRIVATE METHODS
 // ====================
 
-void TorrentManager::syncTorrentsInternal() {
+void TorrentManager::onStatusUpdates(const std::vector<lt::torrent_status>& statuses) {
+    std::lock_guard<std::mutex> lock(m_torrentsMutex);
+
+    for (const auto& status : statuses) {
+        TorrentItem* torrent = findTorrentInternal(status.info_hashes);
+        if (!torrent) {
+            // Not synced yet; the item picks up its status when it is created
+            continue;
+        }
+        torrent->update(status);
+        notifyTorrentUpdated(torrent);
+    }
+    m_snapshotDirty.store(true);
+}
+
+void TorrentManager::onTorrentAdded(const lt::torrent_handle& handle, const lt::add_torrent_params& params) {
+    std::lock_guard<std::mutex> lock(m_torrentsMutex);
+
+    // Already known (e.g. picked up by the startup reconciliation)
+    if (!handle.is_valid() || findTorrentInternal(handle.info_hashes())) {
+        return;
+    }
+    TorrentItem* ptr = insertTorrentInternal(std::make_unique<TorrentItem>(m_statusTable, handle, params));
+    m_snapshotDirty.store(true);
+    notifyTorrentAdded(ptr);
+}
+
+void TorrentManager::onTorrentRemoved(const lt::info_hash_t& hashes) {
+    {
+        // Details requests still waiting will not be answered
+        std::lock_guard<std::mutex> lock(m_requestsMutex);
+        auto it = findRequestsInternal(hashes);
+        if (it != m_requests.end()) m_requests.erase(it);
+    }
+    
+    std::lock_guard<std::mutex> lock(m_torrentsMutex);
+
+    // Torrents removed through removeTorrent() are already gone
+    TorrentItem* torrent = findTorrentInternal(hashes);
+    if (!torrent) {
+        return;
+    }
+    notifyTorrentRemoved(torrent->getHash());
+    eraseTorrentInternal(torrent->getKey());
+    m_snapshotDirty.store(true);
+}
+
+void TorrentManager::onPeerInfo(const lt::torrent_handle& handle, const std::vector<lt::peer_info>& peers) {
+    if (!handle.is_valid()) return;
+    
+    std::vector<PeersCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_requestsMutex);
+        auto it = findRequestsInternal(handle.info_hashes());
+        if (it == m_requests.end()) return;
+        callbacks.swap(it->second.peers);
+        if (it->second.files.empty()) m_requests.erase(it);
+    }
+    if (callbacks.empty()) return;
+    
+    std::vector<TorrentItem::PeerInfo> result = TorrentItem::toPeerInfo(peers);
+    for (size_t i = 0; i < callbacks.size(); i++) {
+        callbacks[i](i + 1 < callbacks.size() ? result : std::move(result));
+    }
+}
+
+void TorrentManager::onFileProgress(const lt::torrent_handle& handle, const std::vector<std::int64_t>& progress) {
+    if (!handle.is_valid()) return;
+    
+    std::vector<FilesCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_requestsMutex);
+        auto it = findRequestsInternal(handle.info_hashes());
+        if (it == m_requests.end()) return;
+        callbacks.swap(it->second.files);
+        if (it->second.peers.empty()) m_requests.erase(it);
+    }
+    if (callbacks.empty()) return;
+    
+    // Names and sizes come from what the item kept at add time
+    lt::info_hash_t hashes = handle.info_hashes();
+    std::shared_ptr<const lt::torrent_info> info;
+    {
+        std::lock_guard<std::mutex> lock(m_torrentsMutex);
+        const TorrentItem* torrent = findTorrentInternal(hashes);
+        if (!torrent) return;
+        info = torrent->getTorrentInfo();
+    }
+    if (!info && !progress.empty()) {
+        // Magnet whose metadata arrived after the add: fetch it once
+        info = handle.torrent_file();
+        std::lock_guard<std::mutex> lock(m_torrentsMutex);
+        if (TorrentItem* torrent = findTorrentInternal(hashes)) {
+            torrent->setTorrentInfo(info);
+        }
+    }
+    std::vector<TorrentItem::FileInfo> result;
+    if (info) {
+        // Priorities change after the add (the Files tab, set_file_priority);
+        // we are on the engine thread, so one call gets all of them cheaply
+        result = TorrentItem::toFileInfo(*info, handle.get_file_priorities(), progress);
+    }
+    for (size_t i = 0; i < callbacks.size(); i++) {
+        callbacks[i](i + 1 < callbacks.size() ? result : std::move(result));
+    }
+}
+
+void TorrentManager::reconcileTorrentsInternal() {
     // IMPORTANT: Caller must hold m_torrentsMutex
     
     if (!m_initialized.load()) {
@@ -376,33 +627,28 @@ void TorrentManager::syncTorrentsInternal() {
 
     auto handles = m_session->getTorrents();
     
-    // 1. Identify torrents to remove
-    std::vector<std::string> toRemove;
-    for (const auto& item : m_torrents) {
-        if (!item) continue;
-        
-        std::string hash = item->getHash();
-        auto it = std::find_if(handles.begin(), handles.end(),
-            [&hash](const lt::torrent_handle& h) {
-                return h.is_valid() && 
-                       TorrentItem::toHex(h.info_hashes().v1) == hash;
-            });
-            
-        if (it == handles.end()) {
-            toRemove.push_back(hash);
+    // 1. Collect the keys libtorrent currently knows about (O(N))
+    std::unordered_set<TorrentItem::Key, TorrentItem::KeyHash> present;
+    present.reserve(handles.size());
+    for (const auto& handle : handles) {
+        if (handle.is_valid()) {
+            lt::info_hash_t hashes = handle.info_hashes();
+            present.insert(TorrentItem::keyOf(hashes));
+            TorrentItem::Key alias;
+            if (TorrentItem::aliasKeyOf(hashes, alias)) present.insert(alias);
         }
     }
     
-    // 2. Remove identified torrents
-    for (const auto& hash : toRemove) {
-        notifyTorrentRemoved(hash);
-        m_torrents.erase(
-            std::remove_if(m_torrents.begin(), m_torrents.end(),
-                [&hash](const std::unique_ptr<TorrentItem>& item) {
-                    return item && item->getHash() == hash;
-                }),
-            m_torrents.end()
-        );
+    // 2. Remove torrents that are gone from the session
+    std::vector<TorrentItem::Key> toRemove;
+    for (const auto& item : m_torrents) {
+        if (present.find(item->getKey()) == present.end()) {
+            toRemove.push_back(item->getKey());
+        }
+    }
+    for (const auto& key : toRemove) {
+        notifyTorrentRemoved(findTorrentInternal(key)->getHash());
+        eraseTorrentInternal(key);
     }
 
     // 3. Add new torrents
@@ -411,51 +657,132 @@ void TorrentManager::syncTorrentsInternal() {
             continue;
         }
 
-        std::string hash = TorrentItem::toHex(handle.info_hashes().v1);
-        
-        if (!findTorrentInternal(hash)) {
-            // Add extra trackers for better connectivity
-            std::ifstream trackerFile("trackersadd.txt");
-            if (trackerFile.is_open()) {
-                std::string tracker;
-                while (std::getline(trackerFile, tracker)) {
-                    if (!tracker.empty() && tracker.length() > 5) {
-                        lt::announce_entry ae(tracker);
-                        handle.add_tracker(ae);
-                    }
-                }
-                trackerFile.close();
-                handle.force_reannounce();
-            }
-
-            auto newTorrent = std::make_unique<TorrentItem>(handle);
-            TorrentItem* ptr = newTorrent.get();
-            m_torrents.push_back(std::move(newTorrent));
+        if (!findTorrentInternal(handle.info_hashes())) {
+            TorrentItem* ptr = insertTorrentInternal(std::make_unique<TorrentItem>(m_statusTable, handle));
             notifyTorrentAdded(ptr);
         }
     }
+    m_snapshotDirty.store(true);
 }
 
 TorrentItem* TorrentManager::findTorrentInternal(const std::string& hash) {
     // IMPORTANT: Caller must hold m_torrentsMutex
     
-    auto it = std::find_if(m_torrents.begin(), m_torrents.end(),
-        [&hash](const std::unique_ptr<TorrentItem>& item) {
-            return item->getHash() == hash;
-        });
-    
-    return it != m_torrents.end() ? it->get() : nullptr;
+    TorrentItem::Key key;
+    if (!TorrentItem::fromHex(hash, key)) {
+        return nullptr;
+    }
+    return findTorrentInternal(key);
 }
 
 const TorrentItem* TorrentManager::findTorrentInternal(const std::string& hash) const {
     // IMPORTANT: Caller must hold m_torrentsMutex
     
-    auto it = std::find_if(m_torrents.begin(), m_torrents.end(),
-        [&hash](const std::unique_ptr<TorrentItem>& item) {
-            return item->getHash() == hash;
-        });
+    TorrentItem::Key key;
+    if (!TorrentItem::fromHex(hash, key)) {
+        return nullptr;
+    }
+    return findTorrentInternal(key);
+}
+
+TorrentItem* TorrentManager::findTorrentInternal(const TorrentItem::Key& key) {
+    // IMPORTANT: Caller must hold m_torrentsMutex
+    
+    auto it = m_index.find(key);
+    return it != m_index.end() ? m_torrents[it->second].get() : nullptr;
+}
+
+const TorrentItem* TorrentManager::findTorrentInternal(const TorrentItem::Key& key) const {
+    // IMPORTANT: Caller must hold m_torrentsMutex
+    
+    auto it = m_index.find(key);
+    return it != m_index.end() ? m_torrents[it->second].get() : nullptr;
+}
+
+TorrentItem* TorrentManager::findTorrentInternal(const lt::info_hash_t& hashes) {
+    // IMPORTANT: Caller must hold m_torrentsMutex
+    
+    if (TorrentItem* torrent = findTorrentInternal(TorrentItem::keyOf(hashes))) {
+        return torrent;
+    }
+    TorrentItem::Key alias;
+    return TorrentItem::aliasKeyOf(hashes, alias) ? findTorrentInternal(alias) : nullptr;
+}
+
+decltype(TorrentManager::m_requests)::iterator TorrentManager::findRequestsInternal(const lt::info_hash_t& hashes) {
+    // IMPORTANT: Caller must hold m_requestsMutex
     
-    return it != m_torrents.end() ? it->get() : nullptr;
+    auto it = m_requests.find(TorrentItem::keyOf(hashes));
+    TorrentItem::Key alias;
+    if (it == m_requests.end() && TorrentItem::aliasKeyOf(hashes, alias)) {
+        it = m_requests.find(alias);
+    }
+    return it;
+}
+
+TorrentItem* TorrentManager::insertTorrentInternal(std::unique_ptr<TorrentItem> torrent) {
+    // IMPORTANT: Caller must hold m_torrentsMutex
+    
+    TorrentItem* ptr = torrent.get();
+    m_index[ptr->getKey()] = m_torrents.size();
+    m_torrents.push_back(std::move(torrent));
+    return ptr;
+}
+
+void TorrentManager::eraseTorrentInternal(const TorrentItem::Key& key) {
+    // IMPORTANT: Caller must hold m_torrentsMutex
+    
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return;
+    }
+
+    // Swap with the last element and pop, so removal stays O(1)
+    size_t pos = it->second;
+    m_index.erase(it);
+    if (pos != m_torrents.size() - 1) {
+        m_torrents[pos] = std::move(m_torrents.back());
+        m_index[m_torrents[pos]->getKey()] = pos;
+    }
+    m_torrents.pop_back();
+}
+
+lt::torrent_handle TorrentManager::findHandle(const std::string& hash) const {
+    std::lock_guard<std::mutex> lock(m_torrentsMutex);
+    const TorrentItem* torrent = findTorrentInternal(hash);
+    return torrent ? torrent->getHandle() : lt::torrent_handle();
+}
+
+std::shared_ptr<const TorrentSnapshot> TorrentManager::getSnapshot() const {
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    return m_snapshot;
+}
+
+void TorrentManager::publishSnapshot() {
+    auto snapshot = std::make_shared<TorrentSnapshot>();
+    {
+        std::lock_guard<std::mutex> lock(m_torrentsMutex);
+        std::vector<TorrentStatusTable::Slot> slots;
+        slots.reserve(m_torrents.size());
+        snapshot->keys.reserve(m_torrents.size());
+        snapshot->hashes.reserve(m_torrents.size());
+        for (const auto& torrent : m_torrents) {
+            slots.push_back(torrent->getSlot());
+            snapshot->keys.push_back(torrent->getKey());
+            snapshot->hashes.push_back(torrent->getHash());
+        }
+        // Column copy under a single table lock
+        snapshot->labelsVersion = m_statusTable.copyRows(slots, snapshot->columns);
+    }
+    snapshot->epoch = ++m_snapshotEpoch;
+    snapshot->finalize();
+    std::shared_ptr<const TorrentSnapshot> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        previous = std::move(m_snapshot);
+        m_snapshot = std::move(snapshot);
+    }
+    // previous (possibly the last reference) is freed outside the lock
 }
 
 void TorrentManager::notifyTorrentAdded(TorrentItem* item) {
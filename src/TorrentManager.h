@@ -3,13 +3,19 @@
 
 #include "TorrentSession.h"
 #include "TorrentItem.h"
+#include "TorrentStatusTable.h"
+#include "TorrentSnapshot.h"
 #include <vector>
 #include <memory>
 #include <functional>
 #include <string>
+#include <unordered_map>
 #include <mutex>
 #include <atomic>
 #include <future>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
 
 /**
  * @brief Thread-safe torrent manager with stable architecture
@@ -19,6 +25,8 @@
  * - Thread-safe operations with mutex protection
  * - Async API support with std::future
  * - Callbacks to UI for state changes
+ * - Engine thread that drains alerts as soon as libtorrent posts them
+ *   (callbacks are invoked on that thread, not on the UI thread)
  * - libtorrent handles internal multi-threading for network/disk I/O
  */
 class TorrentManager {
@@ -29,6 +37,8 @@ public:
     using TorrentUpdatedCallback = std::function<void(TorrentItem*)>;
     using StatsUpdatedCallback = std::function<void()>;
     using ErrorCallback = std::function<void(const std::string& error)>;
+    using PeersCallback = std::function<void(std::vector<TorrentItem::PeerInfo> peers)>;
+    using FilesCallback = std::function<void(std::vector<TorrentItem::FileInfo> files)>;
 
     TorrentManager();
     ~TorrentManager();
@@ -60,21 +70,41 @@ public:
     std::vector<const TorrentItem*> getAllTorrents() const;
     int getTorrentCount() const;
 
+    // Latest published status snapshot (never null). Only the pointer copy
+    // is locked; readers then use the snapshot without any lock.
+    std::shared_ptr<const TorrentSnapshot> getSnapshot() const;
+
+    // Trackers as last reported by the tracker alerts; cheap enough for the
+    // UI thread
+    std::vector<TorrentItem::TrackerInfo> getTrackers(const std::string& hash) const;
+    // Peers and files can be large, so they are only requested here; the
+    // callback gets them later, on the engine thread. Requests for the same
+    // torrent made before the answer arrives share it. Returns false (and
+    // never calls back) if the torrent is gone.
+    bool requestPeers(const std::string& hash, PeersCallback callback);
+    bool requestFiles(const std::string& hash, FilesCallback callback);
+
     // Statistics (thread-safe)
     int getTotalDownloadRate() const;
     int getTotalUploadRate() const;
     int getActiveTorrentsCount() const;
+    int getConnectedPeers() const;
+    int getDhtNodes() const;
     std::string getSessionStats() const;
+    // Changes whenever getSessionStats() has a new sample to show
+    std::uint64_t getSessionStatsSerial() const;
+    // Per tracker host: trackers waiting in the announce scheduler
+    std::vector<AnnounceScheduler::QueueDepth> getAnnounceQueueDepths() const;
 
     // IP and Country
     std::string getPublicIp() const;
     std::string getCountryCode() const;
 
-    // Update - called from UI thread timer (thread-safe)
-    void update();
-    void processAlerts();
+    // Ask the engine thread for fresh torrent statuses now rather than on
+    // its next tick (e.g. after pause/resume)
+    void requestRefresh();
 
-    // Callbacks (called from UI thread)
+    // Callbacks (invoked on the engine thread; UI code must marshal with Fl::awake)
     void setOnTorrentAdded(TorrentAddedCallback callback);
     void setOnTorrentRemoved(TorrentRemovedCallback callback);
     void setOnTorrentUpdated(TorrentUpdatedCallback callback);
@@ -84,8 +114,21 @@ public:
 private:
     // Core data
     std::unique_ptr<TorrentSession> m_session;
+    // Status columns for every item; declared first so it outlives them
+    TorrentStatusTable m_statusTable;
     std::vector<std::unique_ptr<TorrentItem>> m_torrents;
+    // Info-hash -> position in m_torrents (kept in sync by insert/erase helpers)
+    std::unordered_map<TorrentItem::Key, size_t, TorrentItem::KeyHash> m_index;
     std::atomic<bool> m_initialized;
+    
+    // Status snapshot for readers; the engine thread builds and swaps in a
+    // new one in publishSnapshot() after status deltas mark it dirty
+    // std::atomic<std::shared_ptr> is missing from libc++, so a plain mutex
+    // guards the swap
+    std::shared_ptr<const TorrentSnapshot> m_snapshot;
+    mutable std::mutex m_snapshotMutex;
+    std::atomic<bool> m_snapshotDirty;
+    uint64_t m_snapshotEpoch;
     std::atomic<bool> m_running;
 
     // IP and Country
@@ -93,11 +136,22 @@ private:
     std::string m_countryCode;
     mutable std::mutex m_ipMutex;
     std::chrono::steady_clock::time_point m_lastIpCheck;
+    std::chrono::steady_clock::time_point m_lastStatsPost;
 
     // Thread synchronization
     mutable std::mutex m_torrentsMutex;
     mutable std::mutex m_callbacksMutex;
 
+    // Engine thread: sleeps until libtorrent posts alerts, a refresh is
+    // requested or the next periodic tick is due
+    std::thread m_engineThread;
+    std::mutex m_engineMutex;
+    std::condition_variable m_engineCv;
+    bool m_alertsPending;                  // protected by m_engineMutex
+    std::atomic<bool> m_refreshRequested;
+    std::chrono::steady_clock::time_point m_lastResumeSave;
+    static constexpr std::chrono::milliseconds ENGINE_TICK{500};
+
     // Callbacks (protected by m_callbacksMutex)
     TorrentAddedCallback m_onTorrentAdded;
     TorrentRemovedCallback m_onTorrentRemoved;
@@ -105,10 +159,45 @@ private:
     StatsUpdatedCallback m_onStatsUpdated;
     ErrorCallback m_onError;
 
+    // Details requests waiting for their alert, per torrent
+    struct DetailsRequests {
+        std::vector<PeersCallback> peers;
+        std::vector<FilesCallback> files;
+        std::chrono::steady_clock::time_point peersPosted;
+        std::chrono::steady_clock::time_point filesPosted;
+    };
+    std::mutex m_requestsMutex;
+    std::unordered_map<TorrentItem::Key, DetailsRequests, TorrentItem::KeyHash> m_requests;
+    // Caller holds m_requestsMutex; also tries the alias key
+    decltype(m_requests)::iterator findRequestsInternal(const lt::info_hash_t& hashes);
+    // A request older than this is posted again, in case its alert was lost
+    static constexpr std::chrono::seconds DETAILS_REQUEST_TIMEOUT{10};
+
+    // Engine thread
+    void engineLoop();
+    void runPeriodicTasks(std::chrono::steady_clock::time_point now);
+    void wakeEngine();
+
+    // Session events (called from TorrentSession::processAlerts)
+    void onStatusUpdates(const std::vector<lt::torrent_status>& statuses);
+    void onTorrentAdded(const lt::torrent_handle& handle, const lt::add_torrent_params& params);
+    void onTorrentRemoved(const lt::info_hash_t& hashes);
+    void onPeerInfo(const lt::torrent_handle& handle, const std::vector<lt::peer_info>& peers);
+    void onFileProgress(const lt::torrent_handle& handle, const std::vector<std::int64_t>& progress);
+
     // Helper methods (require mutex to be held by caller)
-    void syncTorrentsInternal();
+    void reconcileTorrentsInternal();
     TorrentItem* findTorrentInternal(const std::string& hash);
     const TorrentItem* findTorrentInternal(const std::string& hash) const;
+    TorrentItem* findTorrentInternal(const TorrentItem::Key& key);
+    const TorrentItem* findTorrentInternal(const TorrentItem::Key& key) const;
+    // By the hashes libtorrent reports now; also finds a torrent still
+    // keyed by the alias it was added under (see TorrentItem::aliasKeyOf)
+    TorrentItem* findTorrentInternal(const lt::info_hash_t& hashes);
+    TorrentItem* insertTorrentInternal(std::unique_ptr<TorrentItem> torrent);
+    void eraseTorrentInternal(const TorrentItem::Key& key);
+    lt::torrent_handle findHandle(const std::string& hash) const;
+    void publishSnapshot();
     
     // Thread-safe notification methods
     void notifyTorrentAdded(TorrentItem* item);
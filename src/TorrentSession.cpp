@@ -1,9 +1,10 @@
 #include "TorrentSession.h"
 #include <libtorrent/session_params.hpp>
-#include <libtorrent/read_resume_data.hpp>
 #include <libtorrent/alert_types.hpp>
 #include <libtorrent/torrent_info.hpp>
+#include <libtorrent/announce_entry.hpp>
 #include <iostream>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <libtorrent/write_resume_data.hpp>
@@ -15,7 +16,12 @@
 namespace fs = std::filesystem;
 
 TorrentSession::TorrentSession() 
-    : m_initialized(false) {
+    : m_initialized(false)
+    , m_extraTrackers("trackersadd.txt") {
+    // Demoted trackers are not attached until they recover
+    m_announces.setHold([this](const std::string& url) {
+        return m_trackerHealth.isDemoted(url);
+    });
 }
 
 TorrentSession::~TorrentSession() {
@@ -43,7 +49,8 @@ bool TorrentSession::initialize() {
             lt::alert_category::connect |
             lt::alert_category::peer |
             lt::alert_category::dht |
-            lt::alert_category::port_mapping);
+            lt::alert_category::port_mapping |
+            lt::alert_category::file_progress); // file_progress_alert for the details view
         
         // Connectivity and Discovery
         params.settings.set_bool(lt::settings_pack::enable_dht, sm.getDHTEnabled());
@@ -63,6 +70,10 @@ bool TorrentSession::initialize() {
         params.settings.set_int(lt::settings_pack::active_downloads, 20);
         params.settings.set_int(lt::settings_pack::active_seeds, 20);
         params.settings.set_int(lt::settings_pack::active_limit, 50);
+        // Announces libtorrent sends on its own (auto-managed starts,
+        // reannounces) are not paced per host; cap how many HTTP ones
+        // can be in flight at once
+        params.settings.set_int(lt::settings_pack::max_concurrent_http_announces, 20);
 
         if (sm.getMaxDownloadRate() > 0)
             params.settings.set_int(lt::settings_pack::download_rate_limit, sm.getMaxDownloadRate() * 1024);
@@ -80,6 +91,10 @@ bool TorrentSession::initialize() {
         // Apply RAM mode settings
         setRamMode(sm.getRamMode());
         
+        openResumeStorage(sm.getResumeStorage());
+        m_resumeWriter = std::make_unique<ResumeDataWriter>(getResumeDataPath(), m_resumeStore.get());
+        m_resumeWriter->start();
+        
         m_initialized = true;
         std::cout << "TorrentSession initialized with port " << sm.getListenPort() << std::endl;
         return true;
@@ -94,6 +109,12 @@ void TorrentSession::shutdown() {
     if (m_initialized && m_session) {
         std::cout << "Shutting down TorrentSession..." << std::endl;
         
+        // Stop feeding the session before it goes away
+        if (m_resumeLoader) {
+            m_resumeLoader->stop();
+            m_resumeLoader.reset();
+        }
+        
         // Pause all torrents
         std::vector<lt::torrent_handle> torrents = m_session->get_torrents();
         for (auto& handle : torrents) {
@@ -103,6 +124,14 @@ void TorrentSession::shutdown() {
         }
         
         m_session.reset();
+        
+        // Flush resume files still queued
+        if (m_resumeWriter) {
+            m_resumeWriter->stop();
+        }
+        if (m_resumeStore) {
+            m_resumeStore->close();
+        }
         m_initialized = false;
     }
 }
@@ -112,6 +141,55 @@ void TorrentSession::setupSessionSettings() {
     // For now, using defaults from initialize()
 }
 
+void TorrentSession::prepareAdd(lt::add_torrent_params& params) {
+    m_extraTrackers.apply(params);
+    
+    // A private torrent has no DHT or local discovery to find peers while
+    // its trackers wait their turn, so it keeps them and announces at once
+    if (params.ti && params.ti->priv()) {
+        return;
+    }
+    
+    // The torrent starts right away, but its trackers are taken out and
+    // attached by m_announces when their host's turn comes, since that is
+    // what sends the first announce
+    std::vector<lt::announce_entry> trackers = trackersOf(params);
+    if (params.ti) {
+        params.ti->clear_trackers();
+    }
+    params.trackers.clear();
+    params.tracker_tiers.clear();
+    
+    if (!trackers.empty()) {
+        m_announces.stash(TorrentItem::keyOf(infoHashesOf(params)), std::move(trackers));
+    }
+}
+
+std::vector<lt::announce_entry> TorrentSession::trackersOf(const lt::add_torrent_params& params) {
+    std::vector<lt::announce_entry> trackers;
+    auto take = [&trackers](lt::announce_entry ae) {
+        bool known = std::any_of(trackers.begin(), trackers.end(), [&](const lt::announce_entry& t) {
+            return t.url == ae.url;
+        });
+        if (!ae.url.empty() && !known) trackers.push_back(std::move(ae));
+    };
+    if (params.ti) {
+        for (const auto& ae : params.ti->trackers()) {
+            take(ae);
+        }
+    }
+    for (size_t i = 0; i < params.trackers.size(); i++) {
+        lt::announce_entry ae(params.trackers[i]);
+        ae.tier = static_cast<std::uint8_t>(i < params.tracker_tiers.size() ? params.tracker_tiers[i] : 0);
+        take(std::move(ae));
+    }
+    return trackers;
+}
+
+lt::info_hash_t TorrentSession::infoHashesOf(const lt::add_torrent_params& params) {
+    return params.ti ? params.ti->info_hashes() : params.info_hashes;
+}
+
 bool TorrentSession::addTorrentFile(const std::string& torrentFile, const std::string& savePath, const std::vector<int>& file_priorities) {
     if (!m_initialized || !m_session) {
         std::cerr << "Session not initialized" << std::endl;
@@ -133,6 +211,7 @@ bool TorrentSession::addTorrentFile(const std::string& torrentFile, const std::s
         
         // Add flags for better handling
         params.flags |= lt::torrent_flags::auto_managed | lt::torrent_flags::duplicate_is_error;
+        prepareAdd(params);
         
         m_session->async_add_torrent(params);
         
@@ -164,6 +243,7 @@ bool TorrentSession::addMagnetLink(const std::string& magnetLink, const std::str
         }
         
         params.flags |= lt::torrent_flags::auto_managed | lt::torrent_flags::duplicate_is_error;
+        prepareAdd(params);
         
         m_session->async_add_torrent(params);
         
@@ -215,12 +295,53 @@ std::string TorrentSession::getSessionStats() const {
         return "Session not initialized";
     }
 
-    // In libtorrent 2.0, status() is removed. Use metrics system.
-    std::string stats = "Session stats (libtorrent 2.0 system)\n";
-    // TODO: Implement metrics gathering via alerts
+    std::string stats = m_metrics.format();
+    
+    ResumeDataWriter::Stats rw = getResumeWriterStats();
+    stats += "Resume data:        " + std::to_string(rw.filesWritten) + " files, "
+        + TorrentItem::formatSize(static_cast<int64_t>(rw.bytesWritten)) + " written, "
+        + std::to_string(rw.queueDepth) + " queued";
+    if (rw.writeErrors > 0) {
+        stats += ", " + std::to_string(rw.writeErrors) + " errors";
+    }
+    stats += "\n";
+    
+    std::vector<AnnounceScheduler::QueueDepth> queues = m_announces.getQueueDepths();
+    if (!queues.empty()) {
+        stats += "Announce queues:   ";
+        for (size_t i = 0; i < queues.size() && i < 5; i++) {
+            stats += " " + queues[i].host + " " + std::to_string(queues[i].trackers);
+            if (queues[i].held > 0) {
+                stats += "+" + std::to_string(queues[i].held) + " held";
+            }
+            if (queues[i].scrapes > 0) {
+                stats += "+" + std::to_string(queues[i].scrapes) + " scrapes";
+            }
+            stats += i + 1 < queues.size() ? "," : "";
+        }
+        if (queues.size() > 5) {
+            stats += " ...";
+        }
+        stats += "\n";
+    }
+    
+    if (m_resumeStore) {
+        ResumeStore::Stats rs = m_resumeStore->getStats();
+        stats += "Resume store:       " + std::to_string(rs.records) + " records, "
+            + TorrentItem::formatSize(static_cast<int64_t>(rs.liveBytes)) + " live / "
+            + TorrentItem::formatSize(static_cast<int64_t>(rs.fileBytes)) + " on disk, "
+            + std::to_string(rs.compactions) + " compactions\n";
+    }
     return stats;
 }
 
+ResumeDataWriter::Stats TorrentSession::getResumeWriterStats() const {
+    if (!m_resumeWriter) {
+        return ResumeDataWriter::Stats{0, 0, 0, 0, 0};
+    }
+    return m_resumeWriter->getStats();
+}
+
 void TorrentSession::setRateLimits(int downloadKBps, int uploadKBps) {
     if (!m_initialized || !m_session) return;
     
@@ -299,40 +420,93 @@ void TorrentSession::setRamMode(int mode) {
     m_session->apply_settings(pack);
 }
 
+std::uint64_t TorrentSession::getSessionStatsSerial() const {
+    return m_metrics.getSampleSerial();
+}
+
 int TorrentSession::getDownloadRate() const {
+    return m_metrics.getDownloadRate();
+}
+
+int TorrentSession::getUploadRate() const {
+    return m_metrics.getUploadRate();
+}
+
+void TorrentSession::setAlertNotify(std::function<void()> notify) {
     if (!m_initialized || !m_session) {
-        return 0;
+        return;
     }
-    int total = 0;
-    auto handles = m_session->get_torrents();
-    for (const auto& h : handles) {
-        if (h.is_valid()) {
-            total += h.status().download_rate;
-        }
+    m_session->set_alert_notify(notify ? notify : std::function<void()>([]() {}));
+}
+
+void TorrentSession::postSessionStats() {
+    if (!m_initialized || !m_session) {
+        return;
     }
-    return total;
+    m_session->post_session_stats();
 }
 
-int TorrentSession::getUploadRate() const {
+void TorrentSession::releaseAnnounces() {
     if (!m_initialized || !m_session) {
-        return 0;
+        return;
     }
-    int total = 0;
-    auto handles = m_session->get_torrents();
-    for (const auto& h : handles) {
-        if (h.is_valid()) {
-            total += h.status().upload_rate;
+    m_announces.release(std::chrono::steady_clock::now());
+}
+
+std::vector<AnnounceScheduler::QueueDepth> TorrentSession::getAnnounceQueueDepths() const {
+    return m_announces.getQueueDepths();
+}
+
+void TorrentSession::scrapeQueued(const lt::torrent_handle& handle) {
+    // libtorrent scrapes the first tracker it has, the lowest tier attached
+    std::vector<lt::announce_entry> waiting = m_announces.waiting(handle);
+    for (const auto& info : m_torrentTrackers.get(handle)) {
+        bool queued = std::any_of(waiting.begin(), waiting.end(), [&](const lt::announce_entry& ae) {
+            return ae.url == info.url;
+        });
+        if (!queued) {
+            m_announces.scrape(handle, info.url);
+            return;
         }
     }
-    return total;
+    m_announces.scrape(handle, std::string());
 }
 
-void TorrentSession::removeResumeData(const std::string& hash) {
-    std::string path = getResumeDataPath();
-    std::string fileName = path + "/" + hash + ".fastresume";
-    if (fs::exists(fileName)) {
-        fs::remove(fileName);
+std::vector<TorrentItem::TrackerInfo> TorrentSession::getTrackers(const lt::torrent_handle& handle) const {
+    std::vector<TorrentItem::TrackerInfo> trackers = m_torrentTrackers.get(handle);
+    std::vector<lt::announce_entry> waiting = m_announces.waiting(handle);
+    for (auto& info : trackers) {
+        bool queued = std::any_of(waiting.begin(), waiting.end(), [&](const lt::announce_entry& ae) {
+            return ae.url == info.url;
+        });
+        if (queued) info.status = "Queued";
+        TorrentItem::applyHealth(info, m_trackerHealth);
     }
+    return trackers;
+}
+
+void TorrentSession::removeResumeData(const lt::torrent_handle& handle, const std::string& hash) {
+    if (!m_resumeWriter) return;
+    
+    std::string moved;
+    {
+        std::lock_guard<std::mutex> lock(m_resumeKeysMutex);
+        auto it = m_resumeKeys.find(handle);
+        if (it != m_resumeKeys.end()) {
+            moved = TorrentItem::toHex(it->second);
+        }
+    }
+    m_resumeWriter->remove(hash);
+    if (!moved.empty() && moved != hash) {
+        m_resumeWriter->remove(moved);
+    }
+}
+
+void TorrentSession::postTorrentUpdates() {
+    if (!m_initialized || !m_session) {
+        return;
+    }
+    m_session->post_torrent_updates(TorrentItem::STATUS_QUERY_FLAGS);
 }
 
 void TorrentSession::processAlerts() {
@@ -345,7 +519,22 @@ void TorrentSession::processAlerts() {
     
     for (lt::alert* alert : alerts) {
         // Handle different alert types
-        if (auto* err = lt::alert_cast<lt::torrent_error_alert>(alert)) {
+        if (auto* su = lt::alert_cast<lt::state_update_alert>(alert)) {
+            for (const auto& st : su->status) {
+                // Queued by libtorrent with its swarm size still unknown
+                if ((st.flags & lt::torrent_flags::paused) && (st.flags & lt::torrent_flags::auto_managed)
+                    && st.num_complete < 0) {
+                    scrapeQueued(st.handle);
+                }
+            }
+            if (m_statusUpdateCallback && !su->status.empty()) {
+                m_statusUpdateCallback(su->status);
+            }
+        }
+        else if (auto* ss = lt::alert_cast<lt::session_stats_alert>(alert)) {
+            m_metrics.addSample(ss->counters());
+        }
+        else if (auto* err = lt::alert_cast<lt::torrent_error_alert>(alert)) {
             std::string msg = std::string("Torrent error [") + err->torrent_name() + "]: " + err->message();
             std::cerr << msg << std::endl;
             if (m_errorCallback) m_errorCallback(msg);
@@ -360,13 +549,36 @@ void TorrentSession::processAlerts() {
                 std::string msg = std::string("Failed to add torrent: ") + add->error.message();
                 std::cerr << msg << std::endl;
                 if (m_errorCallback) m_errorCallback(msg);
+                m_announces.dropStash(TorrentItem::keyOf(infoHashesOf(add->params)));
             } else {
                 add->handle.set_flags(lt::torrent_flags::auto_managed);
                 add->handle.resume(); // Ensure it starts
+                TorrentItem::Key key = TorrentItem::keyOf(infoHashesOf(add->params));
+                {
+                    std::lock_guard<std::mutex> lock(m_resumeKeysMutex);
+                    m_resumeKeys[add->handle] = key;
+                }
+                // Trackers taken out by prepareAdd(), or the ones a private
+                // torrent kept
+                std::vector<lt::announce_entry> trackers = m_announces.schedule(add->handle, key);
+                if (trackers.empty()) {
+                    trackers = trackersOf(add->params);
+                }
+                m_torrentTrackers.add(add->handle, trackers);
                 // Trigger an initial save
                 add->handle.save_resume_data();
+                if (m_torrentAddedCallback) m_torrentAddedCallback(add->handle, add->params);
             }
         }
+        else if (auto* rm = lt::alert_cast<lt::torrent_removed_alert>(alert)) {
+            m_announces.forget(rm->handle);
+            {
+                std::lock_guard<std::mutex> lock(m_resumeKeysMutex);
+                m_resumeKeys.erase(rm->handle);
+            }
+            m_torrentTrackers.remove(rm->handle);
+            if (m_torrentRemovedCallback) m_torrentRemovedCallback(rm->info_hashes);
+        }
         else if (auto* ma = lt::alert_cast<lt::metadata_received_alert>(alert)) {
             std::cout << "Metadata received for: " << ma->torrent_name() << std::endl;
             ma->handle.save_resume_data();
@@ -377,9 +589,41 @@ void TorrentSession::processAlerts() {
         else if (auto* rdf = lt::alert_cast<lt::save_resume_data_failed_alert>(alert)) {
             std::cerr << "Save resume data failed: " << rdf->message() << std::endl;
         }
+        else if (auto* tan = lt::alert_cast<lt::tracker_announce_alert>(alert)) {
+            m_trackerHealth.onAnnounce(tan->handle, tan->tracker_url());
+            m_torrentTrackers.onAnnounce(tan->handle, tan->tracker_url());
+        }
+        else if (auto* tra = lt::alert_cast<lt::tracker_reply_alert>(alert)) {
+            m_trackerHealth.onReply(tra->handle, tra->tracker_url(), tra->num_peers);
+            m_torrentTrackers.onReply(tra->handle, tra->tracker_url());
+        }
+        else if (auto* twa = lt::alert_cast<lt::tracker_warning_alert>(alert)) {
+            m_torrentTrackers.onWarning(twa->handle, twa->tracker_url(), twa->warning_message());
+        }
         else if (auto* tea = lt::alert_cast<lt::tracker_error_alert>(alert)) {
             // Log tracker errors but don't alert user every time as they are common
             std::cerr << "Tracker error: " << tea->tracker_url() << " - " << tea->error_message() << std::endl;
+            
+            // A failure reason means the tracker answered
+            std::string url = tea->tracker_url();
+            bool reachable = tea->failure_reason()[0] != '\0';
+            bool wasDemoted = m_trackerHealth.isDemoted(url);
+            m_trackerHealth.onError(tea->handle, url, tea->error_message(), reachable);
+            m_torrentTrackers.onError(tea->handle, url, tea->error_message());
+            if (!wasDemoted && m_trackerHealth.isDemoted(url)) {
+                // Torrents that have it already leave it to libtorrent's
+                // backoff; new ones do not attach it until it recovers
+                std::cerr << "Demoting unreachable tracker: " << url << std::endl;
+            }
+        }
+        else if (auto* sra = lt::alert_cast<lt::scrape_reply_alert>(alert)) {
+            m_trackerHealth.onScrape(sra->tracker_url(), sra->complete, sra->incomplete);
+        }
+        else if (auto* pia = lt::alert_cast<lt::peer_info_alert>(alert)) {
+            if (m_peerInfoCallback) m_peerInfoCallback(pia->handle, pia->peer_info);
+        }
+        else if (auto* fpa = lt::alert_cast<lt::file_progress_alert>(alert)) {
+            if (m_fileProgressCallback) m_fileProgressCallback(fpa->handle, fpa->files);
         }
     }
 }
@@ -387,66 +631,100 @@ void TorrentSession::processAlerts() {
 void TorrentSession::triggerSaveResumeData() {
     if (!m_initialized || !m_session) return;
     
-    auto torrents = m_session->get_torrents();
-    for (auto& h : torrents) {
-        if (h.is_valid() && h.status().has_metadata) {
-            h.save_resume_data();
+    // One query for the torrents whose state changed since their last
+    // save, instead of a status() round-trip for every torrent
+    auto dirty = m_session->get_torrent_status([](const lt::torrent_status& st) {
+        return st.need_save_resume && st.has_metadata;
+    }, {});
+    for (const auto& st : dirty) {
+        if (st.handle.is_valid()) {
+            st.handle.save_resume_data();
         }
     }
 }
 
 void TorrentSession::loadResidentTorrents() {
-    if (!m_initialized || !m_session) return;
-    
-    std::string path = getResumeDataPath();
-    if (!fs::exists(path)) return;
+    if (!m_initialized || !m_session || m_resumeLoader) return;
     
-    int loaded = 0;
-    for (const auto& entry : fs::directory_iterator(path)) {
-        if (entry.path().extension() == ".fastresume") {
-            try {
-                std::ifstream is(entry.path(), std::ios::binary);
-                std::vector<char> resume_data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
-                
-                if (resume_data.empty()) continue;
-                
-                lt::error_code ec;
-                lt::add_torrent_params params = lt::read_resume_data(resume_data, ec);
-                
-                if (ec) {
-                    std::cerr << "Error reading resume data: " << ec.message() << std::endl;
-                    continue;
-                }
-                
-                params.flags |= lt::torrent_flags::auto_managed;
-                m_session->async_add_torrent(params);
-                loaded++;
-            } catch (...) {
-                std::cerr << "Failed to load: " << entry.path().string() << std::endl;
+    // async_add_torrent is thread-safe; the loader calls this from its workers
+    m_resumeLoader = std::make_unique<ResumeLoader>(getResumeDataPath(), m_resumeStore.get(),
+        [this](std::vector<lt::add_torrent_params>& batch) {
+            for (auto& params : batch) {
+                prepareAdd(params);
+                m_session->async_add_torrent(std::move(params));
             }
+        });
+    m_resumeLoader->start();
+}
+
+void TorrentSession::openResumeStorage(const std::string& storage) {
+    std::string storePath = getResumeStorePath();
+    std::error_code ec;
+    
+    if (storage == "log") {
+        m_resumeStore = std::make_unique<ResumeStore>(storePath);
+        if (!m_resumeStore->open()) {
+            std::cerr << "Falling back to per-file resume data" << std::endl;
+            m_resumeStore.reset();
+            return;
+        }
+        // Migration: fold any .fastresume files into the log
+        m_resumeStore->importDirectory(getResumeDataPath(), true);
+        return;
+    }
+    
+    // Back to per-file storage: export a log left by "log" mode once
+    if (fs::exists(storePath, ec)) {
+        ResumeStore old(storePath);
+        if (old.open()) {
+            size_t exported = old.exportDirectory(getResumeDataPath());
+            old.close();
+            fs::rename(storePath, storePath + ".migrated", ec);
+            std::cout << "Exported " << exported << " records from " << storePath << std::endl;
         }
     }
-    std::cout << "Loaded " << loaded << " torrents from resume data." << std::endl;
 }
 
 void TorrentSession::writeResumeData(const lt::save_resume_data_alert* rd) {
-    if (!rd) return;
+    if (!rd || !m_resumeWriter) return;
     
-    std::string path = getResumeDataPath();
-    if (!fs::exists(path)) {
-        fs::create_directories(path);
-    }
+    // Bencode here (cheap); disk I/O happens on the writer thread.
+    // Use info-hash as filename.
+    TorrentItem::Key key = TorrentItem::keyOf(rd->params.info_hashes);
+    std::string hash = TorrentItem::toHex(key);
     
-    // Use info-hash as filename
-    std::string hash = TorrentItem::toHex(rd->handle.info_hashes().v1);
-    std::string fileName = path + "/" + hash + ".fastresume";
+    // A v2-only magnet became hybrid: drop the record under its old key,
+    // once, so a restart does not load the torrent twice
+    std::string stale;
+    {
+        std::lock_guard<std::mutex> lock(m_resumeKeysMutex);
+        auto it = m_resumeKeys.find(rd->handle);
+        if (it != m_resumeKeys.end() && it->second != key) {
+            stale = TorrentItem::toHex(it->second);
+            it->second = key;
+        }
+    }
+    if (!stale.empty()) {
+        m_resumeWriter->remove(stale);
+    }
     
-    std::ofstream os(fileName, std::ios::binary);
-    if (os.is_open()) {
-        std::vector<char> bencoded = lt::write_resume_data_buf(rd->params);
-        os.write(bencoded.data(), bencoded.size());
-        os.close();
+    // Trackers still waiting for their turn are not on the torrent yet
+    std::vector<lt::announce_entry> waiting = m_announces.waiting(rd->handle);
+    if (!waiting.empty()) {
+        lt::add_torrent_params params = rd->params;
+        params.tracker_tiers.resize(params.trackers.size(), 0);
+        for (const auto& ae : waiting) {
+            params.trackers.push_back(ae.url);
+            params.tracker_tiers.push_back(ae.tier);
+        }
+        m_resumeWriter->write(hash, lt::write_resume_data_buf(params));
+        return;
     }
+    m_resumeWriter->write(hash, lt::write_resume_data_buf(rd->params));
+}
+
+std::string TorrentSession::getResumeStorePath() const {
+    return (fs::path(getResumeDataPath()).parent_path() / "resume.log").string();
 }
 
 std::string TorrentSession::getResumeDataPath() const {
@@ -7,17 +7,32 @@
 #include <libtorrent/add_torrent_params.hpp>
 #include <libtorrent/alert_types.hpp>
 #include <libtorrent/magnet_uri.hpp>
+#include "SessionMetrics.h"
+#include "ResumeDataWriter.h"
+#include "ResumeStore.h"
+#include "ResumeLoader.h"
+#include "TrackerList.h"
+#include "AnnounceScheduler.h"
+#include "TrackerHealth.h"
+#include "TorrentTrackers.h"
 #include <string>
 #include <vector>
 #include <memory>
 
 #include <functional>
+#include <map>
+#include <mutex>
 
 namespace lt = libtorrent;
 
 class TorrentSession {
 public:
     using ErrorCallback = std::function<void(const std::string&)>;
+    using StatusUpdateCallback = std::function<void(const std::vector<lt::torrent_status>&)>;
+    using TorrentAddedCallback = std::function<void(const lt::torrent_handle&, const lt::add_torrent_params&)>;
+    using TorrentRemovedCallback = std::function<void(const lt::info_hash_t&)>;
+    using PeerInfoCallback = std::function<void(const lt::torrent_handle&, const std::vector<lt::peer_info>&)>;
+    using FileProgressCallback = std::function<void(const lt::torrent_handle&, const std::vector<std::int64_t>&)>;
 
     TorrentSession();
     ~TorrentSession();
@@ -37,31 +52,97 @@ public:
     void setRateLimits(int downloadKBps, int uploadKBps);
     void setRamMode(int mode);
     
-    // Persistence
+    // Persistence. Only torrents flagged need_save_resume are asked to save;
+    // the resulting files are written by m_resumeWriter in the background,
+    // either as <hash>.fastresume files or into m_resumeStore ("log" mode).
     void triggerSaveResumeData();
+    ResumeDataWriter::Stats getResumeWriterStats() const;
+    // Starts loading resident torrents in the background; they show up
+    // through the usual add_torrent_alert path as batches are added.
     void loadResidentTorrents();
-    void removeResumeData(const std::string& hash);
+    // hash is the key the torrent was added under; the record may have
+    // moved since (see m_resumeKeys)
+    void removeResumeData(const lt::torrent_handle& handle, const std::string& hash);
     
     // Information getters
     std::vector<lt::torrent_handle> getTorrents() const;
     std::string getSessionStats() const;
+    // Changes whenever a new session_stats sample arrives
+    std::uint64_t getSessionStatsSerial() const;
+    // Session totals from the latest session_stats samples (O(1))
     int getDownloadRate() const;
     int getUploadRate() const;
+    const SessionMetrics& getMetrics() const { return m_metrics; }
+    // Per tracker URL, across all torrents
+    const TrackerHealth& getTrackerHealth() const { return m_trackerHealth; }
+    // A torrent's trackers as the alerts left them; no libtorrent call, so
+    // safe on the UI thread
+    std::vector<TorrentItem::TrackerInfo> getTrackers(const lt::torrent_handle& handle) const;
+    
+    // Ask libtorrent for a session_stats_alert; processAlerts() stores it
+    void postSessionStats();
+    
+    // Attaches the trackers whose host's turn has come; call periodically
+    // from the engine thread
+    void releaseAnnounces();
+    std::vector<AnnounceScheduler::QueueDepth> getAnnounceQueueDepths() const;
+    
+    // Called by libtorrent (on its own thread) when the alert queue goes from
+    // empty to non-empty. Must not call back into the session.
+    void setAlertNotify(std::function<void()> notify);
     
     // Process alerts
     void processAlerts();
     
+    // Ask libtorrent for the status of every torrent that changed since the
+    // last call. Results arrive as a single state_update_alert, which
+    // processAlerts() hands to the status update callback.
+    void postTorrentUpdates();
+    
     // Callbacks
     void setErrorCallback(ErrorCallback cb) { m_errorCallback = cb; }
+    void setStatusUpdateCallback(StatusUpdateCallback cb) { m_statusUpdateCallback = cb; }
+    // Lifecycle events published from add_torrent_alert / torrent_removed_alert
+    void setTorrentAddedCallback(TorrentAddedCallback cb) { m_torrentAddedCallback = cb; }
+    void setTorrentRemovedCallback(TorrentRemovedCallback cb) { m_torrentRemovedCallback = cb; }
+    // Answers to handle.post_peer_info() / post_file_progress()
+    void setPeerInfoCallback(PeerInfoCallback cb) { m_peerInfoCallback = cb; }
+    void setFileProgressCallback(FileProgressCallback cb) { m_fileProgressCallback = cb; }
 
 private:
     std::unique_ptr<lt::session> m_session;
     bool m_initialized;
     ErrorCallback m_errorCallback;
+    StatusUpdateCallback m_statusUpdateCallback;
+    TorrentAddedCallback m_torrentAddedCallback;
+    TorrentRemovedCallback m_torrentRemovedCallback;
+    PeerInfoCallback m_peerInfoCallback;
+    FileProgressCallback m_fileProgressCallback;
+    SessionMetrics m_metrics;
+    std::unique_ptr<ResumeStore> m_resumeStore; // null in "files" mode
+    std::unique_ptr<ResumeDataWriter> m_resumeWriter;
+    std::unique_ptr<ResumeLoader> m_resumeLoader;
+    TrackerList m_extraTrackers; // trackersadd.txt, added to every torrent
+    AnnounceScheduler m_announces;
+    TrackerHealth m_trackerHealth;
+    TorrentTrackers m_torrentTrackers;
+    // Key each torrent's resume record is stored under. It starts as the
+    // add-time key and moves once to the v1 key when a v2-only magnet's
+    // metadata makes the torrent hybrid.
+    std::map<lt::torrent_handle, lt::sha1_hash> m_resumeKeys;
+    mutable std::mutex m_resumeKeysMutex;
     
     void setupSessionSettings();
+    void prepareAdd(lt::add_torrent_params& params);
+    // Queues the one scrape of a torrent libtorrent keeps queued
+    void scrapeQueued(const lt::torrent_handle& handle);
+    static lt::info_hash_t infoHashesOf(const lt::add_torrent_params& params);
+    // Every tracker of the torrent info and params.trackers, once each
+    static std::vector<lt::announce_entry> trackersOf(const lt::add_torrent_params& params);
+    void openResumeStorage(const std::string& storage);
     void writeResumeData(const lt::save_resume_data_alert* rd);
     std::string getResumeDataPath() const;
+    std::string getResumeStorePath() const;
 };
 
 #endif // TORRENTSESSION_H
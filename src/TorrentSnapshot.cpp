@@ -0,0 +1,36 @@
+#include "TorrentSnapshot.h"
+
+int TorrentSnapshot::find(const TorrentItem::Key& key) const {
+    auto it = m_index.find(key);
+    return it != m_index.end() ? it->second : -1;
+}
+
+int TorrentSnapshot::find(const std::string& hash) const {
+    TorrentItem::Key key;
+    if (!TorrentItem::fromHex(hash, key)) {
+        return -1;
+    }
+    return find(key);
+}
+
+void TorrentSnapshot::finalize() {
+    const size_t n = keys.size();
+
+    m_index.clear();
+    m_index.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_index[keys[i]] = static_cast<int>(i);
+    }
+
+    // Straight reduction over one column, which the compiler can vectorise.
+    // Session-wide rates come from SessionMetrics instead.
+    const TorrentItem::State* state = columns.state.data();
+
+    int active = 0;
+    for (size_t i = 0; i < n; ++i) {
+        active += (state[i] == TorrentItem::State::Downloading ||
+                   state[i] == TorrentItem::State::Seeding);
+    }
+
+    activeCount = active;
+}
@@ -0,0 +1,52 @@
+#ifndef TORRENTSNAPSHOT_H
+#define TORRENTSNAPSHOT_H
+
+#include "TorrentItem.h"
+#include "TorrentStatusTable.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @brief Immutable copy of every torrent's status, published once per tick
+ *
+ * TorrentManager builds a new snapshot after applying status deltas and
+ * swaps it in atomically. Readers (list widget, status bar, details dialog)
+ * hold a shared_ptr to it and never take a lock; an old snapshot simply
+ * stays alive until its last reader lets go.
+ *
+ * Rows are dense and stored column by column (see TorrentStatusTable), so
+ * sorts and totals walk contiguous arrays.
+ */
+struct TorrentSnapshot {
+    // Bumped every time the manager publishes a new snapshot
+    uint64_t epoch = 0;
+    // Changes only when a name, save path, tracker host or state changed or
+    // torrents came or went (see TorrentStatusTable)
+    uint64_t labelsVersion = 0;
+
+    // Row i of every column describes keys[i] / hashes[i]
+    std::vector<TorrentItem::Key> keys;
+    std::vector<std::string> hashes;
+    TorrentStatusTable::Columns columns;
+
+    // Aggregates computed while building
+    int activeCount = 0;
+
+    // Row of a torrent, or -1 if it is not in this snapshot
+    int find(const TorrentItem::Key& key) const;
+    int find(const std::string& hash) const;
+    size_t size() const { return keys.size(); }
+    bool empty() const { return keys.empty(); }
+
+    TorrentItem::Status status(size_t row) const { return columns.row(row); }
+
+    // Builds the index and aggregates from the columns
+    void finalize();
+
+private:
+    std::unordered_map<TorrentItem::Key, int, TorrentItem::KeyHash> m_index;
+};
+
+#endif // TORRENTSNAPSHOT_H
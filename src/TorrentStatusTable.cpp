@@ -0,0 +1,220 @@
+#include "TorrentStatusTable.h"
+#include "TrackerList.h"
+#include <libtorrent/torrent_flags.hpp>
+#include <string_view>
+
+void TorrentStatusTable::Columns::reserve(size_t n) {
+    name.reserve(n);
+    savePath.reserve(n);
+    trackerHost.reserve(n);
+    state.reserve(n);
+    totalSize.reserve(n);
+    downloaded.reserve(n);
+    uploaded.reserve(n);
+    progress.reserve(n);
+    downloadRate.reserve(n);
+    uploadRate.reserve(n);
+    numPeers.reserve(n);
+    numSeeds.reserve(n);
+    addedTime.reserve(n);
+    completedTime.reserve(n);
+}
+
+void TorrentStatusTable::Columns::resize(size_t n) {
+    name.resize(n);
+    savePath.resize(n);
+    trackerHost.resize(n);
+    state.resize(n, TorrentItem::State::Queued);
+    totalSize.resize(n, 0);
+    downloaded.resize(n, 0);
+    uploaded.resize(n, 0);
+    progress.resize(n, 0.0);
+    downloadRate.resize(n, 0);
+    uploadRate.resize(n, 0);
+    numPeers.resize(n, 0);
+    numSeeds.resize(n, 0);
+    addedTime.resize(n, 0);
+    completedTime.resize(n, 0);
+}
+
+void TorrentStatusTable::Columns::appendRow(const Columns& from, size_t row) {
+    name.push_back(from.name[row]);
+    savePath.push_back(from.savePath[row]);
+    trackerHost.push_back(from.trackerHost[row]);
+    state.push_back(from.state[row]);
+    totalSize.push_back(from.totalSize[row]);
+    downloaded.push_back(from.downloaded[row]);
+    uploaded.push_back(from.uploaded[row]);
+    progress.push_back(from.progress[row]);
+    downloadRate.push_back(from.downloadRate[row]);
+    uploadRate.push_back(from.uploadRate[row]);
+    numPeers.push_back(from.numPeers[row]);
+    numSeeds.push_back(from.numSeeds[row]);
+    addedTime.push_back(from.addedTime[row]);
+    completedTime.push_back(from.completedTime[row]);
+}
+
+TorrentItem::Status TorrentStatusTable::Columns::row(size_t i) const {
+    TorrentItem::Status s;
+    if (name[i]) s.name = *name[i];
+    if (savePath[i]) s.savePath = *savePath[i];
+    if (trackerHost[i]) s.trackerHost = *trackerHost[i];
+    s.state = state[i];
+    s.totalSize = totalSize[i];
+    s.downloaded = downloaded[i];
+    s.uploaded = uploaded[i];
+    s.progress = progress[i];
+    s.downloadRate = downloadRate[i];
+    s.uploadRate = uploadRate[i];
+    s.numPeers = numPeers[i];
+    s.numSeeds = numSeeds[i];
+    s.addedTime = addedTime[i];
+    s.completedTime = completedTime[i];
+    return s;
+}
+
+void TorrentStatusTable::Columns::setRow(size_t i, const TorrentItem::Status& s) {
+    name[i] = std::make_shared<const std::string>(s.name);
+    savePath[i] = std::make_shared<const std::string>(s.savePath);
+    trackerHost[i] = std::make_shared<const std::string>(s.trackerHost);
+    state[i] = s.state;
+    totalSize[i] = s.totalSize;
+    downloaded[i] = s.downloaded;
+    uploaded[i] = s.uploaded;
+    progress[i] = s.progress;
+    downloadRate[i] = s.downloadRate;
+    uploadRate[i] = s.uploadRate;
+    numPeers[i] = s.numPeers;
+    numSeeds[i] = s.numSeeds;
+    addedTime[i] = s.addedTime;
+    completedTime[i] = s.completedTime;
+}
+
+int TorrentStatusTable::Columns::eta(size_t i) const {
+    return TorrentItem::computeETA(state[i], totalSize[i], downloaded[i], downloadRate[i]);
+}
+
+double TorrentStatusTable::Columns::ratio(size_t i) const {
+    return TorrentItem::computeRatio(uploaded[i], downloaded[i]);
+}
+
+TorrentStatusTable::Slot TorrentStatusTable::allocate(const TorrentItem::Status& initial) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Slot slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = static_cast<Slot>(m_columns.size());
+        m_columns.resize(m_columns.size() + 1);
+    }
+    m_columns.setRow(slot, initial);
+    m_labelsVersion++;
+    return slot;
+}
+
+void TorrentStatusTable::release(Slot slot) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (slot >= m_columns.size()) {
+        return;
+    }
+    // Drop the strings now; the numeric fields are overwritten on reuse
+    m_columns.name[slot].reset();
+    m_columns.savePath[slot].reset();
+    m_columns.trackerHost[slot].reset();
+    m_freeSlots.push_back(slot);
+    m_labelsVersion++;
+}
+
+void TorrentStatusTable::apply(Slot slot, const lt::torrent_status& status) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Columns& c = m_columns;
+
+    // Basic info (only reallocate when it actually changed)
+    if (!c.name[slot] || *c.name[slot] != status.name) {
+        c.name[slot] = std::make_shared<const std::string>(status.name);
+        m_labelsVersion++;
+    }
+    if (!c.savePath[slot] || *c.savePath[slot] != status.save_path) {
+        c.savePath[slot] = std::make_shared<const std::string>(status.save_path);
+        m_labelsVersion++;
+    }
+    std::string_view host = TrackerList::hostOf(status.current_tracker);
+    if (!c.trackerHost[slot] || *c.trackerHost[slot] != host) {
+        c.trackerHost[slot] = std::make_shared<const std::string>(host);
+        m_labelsVersion++;
+    }
+
+    // Size info
+    c.totalSize[slot] = status.total_wanted;
+    c.downloaded[slot] = status.total_wanted_done;
+    c.uploaded[slot] = status.total_upload;
+    c.progress[slot] = status.progress;
+
+    // Speed info
+    c.downloadRate[slot] = status.download_rate;
+    c.uploadRate[slot] = status.upload_rate;
+
+    // Peer info
+    c.numPeers[slot] = status.num_peers;
+    c.numSeeds[slot] = status.num_seeds;
+
+    // State info
+    TorrentItem::State state;
+    if (status.flags & lt::torrent_flags::paused) {
+        state = TorrentItem::State::Paused;
+    } else {
+        state = TorrentItem::convertState(status.state);
+
+        // If finished but seeding
+        if (c.progress[slot] >= 1.0 && state == TorrentItem::State::Downloading) {
+            state = TorrentItem::State::Complete;
+        }
+    }
+    if (status.errc) {
+        state = TorrentItem::State::Error;
+    }
+    if (c.state[slot] != state) {
+        c.state[slot] = state;
+        m_labelsVersion++;
+    }
+
+    // If paused, force rates to 0 for UI clarity
+    if (state == TorrentItem::State::Paused) {
+        c.downloadRate[slot] = 0;
+        c.uploadRate[slot] = 0;
+        c.numPeers[slot] = 0;
+    }
+
+    // Time info
+    c.addedTime[slot] = status.added_time;
+
+    if (status.completed_time > 0) {
+        c.completedTime[slot] = status.completed_time;
+    }
+}
+
+void TorrentStatusTable::setState(Slot slot, TorrentItem::State state) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_columns.state[slot] != state) {
+        m_columns.state[slot] = state;
+        m_labelsVersion++;
+    }
+}
+
+TorrentItem::Status TorrentStatusTable::get(Slot slot) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_columns.row(slot);
+}
+
+uint64_t TorrentStatusTable::copyRows(const std::vector<Slot>& slots, Columns& out) const {
+    out.reserve(out.size() + slots.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Slot slot : slots) {
+        out.appendRow(m_columns, slot);
+    }
+    return m_labelsVersion;
+}
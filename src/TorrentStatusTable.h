@@ -0,0 +1,93 @@
+#ifndef TORRENTSTATUSTABLE_H
+#define TORRENTSTATUSTABLE_H
+
+#include "TorrentItem.h"
+#include <libtorrent/torrent_status.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Columnar (struct-of-arrays) store for the status of every torrent
+ *
+ * Each field lives in its own contiguous array indexed by a dense slot id.
+ * TorrentItem only remembers its slot, so sorting, filtering and totals are
+ * plain loops over one array instead of pointer chasing through items.
+ * Freed slots are reused, keeping the arrays dense.
+ */
+class TorrentStatusTable {
+public:
+    using Slot = uint32_t;
+    static constexpr Slot INVALID_SLOT = UINT32_MAX;
+
+    struct Columns {
+        // Names and paths rarely change: they are shared and only replaced
+        // when different, so copying the columns just bumps refcounts
+        std::vector<std::shared_ptr<const std::string>> name;
+        std::vector<std::shared_ptr<const std::string>> savePath;
+        std::vector<std::shared_ptr<const std::string>> trackerHost;  // of the current tracker
+        std::vector<TorrentItem::State> state;
+
+        std::vector<int64_t> totalSize;
+        std::vector<int64_t> downloaded;
+        std::vector<int64_t> uploaded;
+        std::vector<double> progress;
+
+        std::vector<int> downloadRate;
+        std::vector<int> uploadRate;
+
+        std::vector<int> numPeers;
+        std::vector<int> numSeeds;
+
+        std::vector<int64_t> addedTime;
+        std::vector<int64_t> completedTime;
+
+        size_t size() const { return state.size(); }
+        void reserve(size_t n);
+        void resize(size_t n);
+        void appendRow(const Columns& from, size_t row);
+
+        TorrentItem::Status row(size_t i) const;
+        void setRow(size_t i, const TorrentItem::Status& status);
+
+        // Derived values, same rules as TorrentItem::Status
+        int eta(size_t i) const;
+        double ratio(size_t i) const;
+    };
+
+    TorrentStatusTable() = default;
+    TorrentStatusTable(const TorrentStatusTable&) = delete;
+    TorrentStatusTable& operator=(const TorrentStatusTable&) = delete;
+
+    Slot allocate(const TorrentItem::Status& initial);
+    void release(Slot slot);
+
+    // Apply a status delivered by libtorrent
+    void apply(Slot slot, const lt::torrent_status& status);
+    void setState(Slot slot, TorrentItem::State state);
+
+    TorrentItem::Status get(Slot slot) const;
+
+    // Single-field read, e.g. field(slot, &Columns::downloadRate)
+    template <typename T>
+    T field(Slot slot, std::vector<T> Columns::* column) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return (m_columns.*column)[slot];
+    }
+
+    // Copies the given slots, in order, into dense rows of out (one lock).
+    // Returns the labels version of the copy.
+    uint64_t copyRows(const std::vector<Slot>& slots, Columns& out) const;
+
+private:
+    mutable std::mutex m_mutex;
+    Columns m_columns;
+    std::vector<Slot> m_freeSlots;
+    // Bumped whenever a name, save path, tracker host or state changes or a
+    // slot is allocated or released, so readers can skip unchanged labels
+    uint64_t m_labelsVersion = 1;
+};
+
+#endif // TORRENTSTATUSTABLE_H
@@ -0,0 +1,79 @@
+#include "TorrentTrackers.h"
+#include <algorithm>
+
+void TorrentTrackers::add(const lt::torrent_handle& handle, const std::vector<lt::announce_entry>& trackers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<TorrentItem::TrackerInfo>& list = m_torrents[handle];
+    for (const auto& ae : trackers) {
+        TorrentItem::TrackerInfo info;
+        info.url = ae.url;
+        info.tier = ae.tier;
+        info.status = "Not contacted";
+        list.push_back(std::move(info));
+    }
+    std::stable_sort(list.begin(), list.end(), [](const TorrentItem::TrackerInfo& a, const TorrentItem::TrackerInfo& b) {
+        return a.tier < b.tier;
+    });
+}
+
+void TorrentTrackers::remove(const lt::torrent_handle& handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_torrents.erase(handle);
+}
+
+void TorrentTrackers::onAnnounce(const lt::torrent_handle& handle, const std::string& url) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (TorrentItem::TrackerInfo* info = entry(handle, url)) {
+        info->status = "Updating...";
+    }
+}
+
+void TorrentTrackers::onReply(const lt::torrent_handle& handle, const std::string& url) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (TorrentItem::TrackerInfo* info = entry(handle, url)) {
+        info->status = "Working";
+        info->message.clear();
+    }
+}
+
+void TorrentTrackers::onWarning(const lt::torrent_handle& handle, const std::string& url, const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (TorrentItem::TrackerInfo* info = entry(handle, url)) {
+        info->message = message;
+    }
+}
+
+void TorrentTrackers::onError(const lt::torrent_handle& handle, const std::string& url, const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (TorrentItem::TrackerInfo* info = entry(handle, url)) {
+        info->status = "Not working";
+        info->message = message;
+    }
+}
+
+std::vector<TorrentItem::TrackerInfo> TorrentTrackers::get(const lt::torrent_handle& handle) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_torrents.find(handle);
+    return it != m_torrents.end() ? it->second : std::vector<TorrentItem::TrackerInfo>();
+}
+
+TorrentItem::TrackerInfo* TorrentTrackers::entry(const lt::torrent_handle& handle, const std::string& url) {
+    // Alerts can trail the torrent's removal (the reply to its "stopped"
+    // announce); those must not bring its entry back
+    auto t = m_torrents.find(handle);
+    if (t == m_torrents.end()) {
+        return nullptr;
+    }
+    std::vector<TorrentItem::TrackerInfo>& list = t->second;
+    auto it = std::find_if(list.begin(), list.end(), [&](const TorrentItem::TrackerInfo& info) {
+        return info.url == url;
+    });
+    if (it != list.end()) {
+        return &*it;
+    }
+    TorrentItem::TrackerInfo info;
+    info.url = url;
+    info.status = "Not contacted";
+    list.push_back(std::move(info));
+    return &list.back();
+}
@@ -0,0 +1,44 @@
+#ifndef TORRENTTRACKERS_H
+#define TORRENTTRACKERS_H
+
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/announce_entry.hpp>
+#include "TorrentItem.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+namespace lt = libtorrent;
+
+/**
+ * @brief Each torrent's trackers and how its last announce to them went
+ *
+ * Filled when a torrent is added (prepareAdd() knows all its trackers) and
+ * kept current from the tracker alerts on the engine thread, so the details
+ * view never has to ask libtorrent for handle.trackers(). Readable from
+ * any thread.
+ */
+class TorrentTrackers {
+public:
+    void add(const lt::torrent_handle& handle, const std::vector<lt::announce_entry>& trackers);
+    void remove(const lt::torrent_handle& handle);
+
+    void onAnnounce(const lt::torrent_handle& handle, const std::string& url);
+    void onReply(const lt::torrent_handle& handle, const std::string& url);
+    void onWarning(const lt::torrent_handle& handle, const std::string& url, const std::string& message);
+    void onError(const lt::torrent_handle& handle, const std::string& url, const std::string& message);
+
+    // url, tier, status and message; the rest is left to the caller
+    std::vector<TorrentItem::TrackerInfo> get(const lt::torrent_handle& handle) const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::map<lt::torrent_handle, std::vector<TorrentItem::TrackerInfo>> m_torrents;
+
+    // Caller holds m_mutex; adds the URL if the torrent did not list it.
+    // Null for a torrent add() never saw or remove() dropped.
+    TorrentItem::TrackerInfo* entry(const lt::torrent_handle& handle, const std::string& url);
+};
+
+#endif // TORRENTTRACKERS_H
@@ -0,0 +1,117 @@
+#include "TrackerHealth.h"
+#include <algorithm>
+#include <ctime>
+
+void TrackerHealth::onAnnounce(const lt::torrent_handle& handle, const std::string& url) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Clock::time_point now = Clock::now();
+
+    // Announces that never got an answer would otherwise pile up. Entries
+    // answered or re-sent since are already gone or newer in m_pending.
+    while (!m_pendingOrder.empty() && now - m_pendingOrder.front().first > PENDING_TIMEOUT) {
+        auto it = m_pending.find(m_pendingOrder.front().second);
+        if (it != m_pending.end() && it->second == m_pendingOrder.front().first) {
+            m_pending.erase(it);
+        }
+        m_pendingOrder.pop_front();
+    }
+    PendingKey key(url, handle);
+    m_pending[key] = now;
+    m_pendingOrder.emplace_back(now, std::move(key));
+    m_trackers[url].entry.url = url;
+}
+
+void TrackerHealth::onReply(const lt::torrent_handle& handle, const std::string& url, int numPeers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    State& state = m_trackers[url];
+    state.entry.url = url;
+
+    finishAnnounce(state, handle, url, now);
+    state.entry.lastSuccess = static_cast<int64_t>(std::time(nullptr));
+    state.entry.failureStreak = 0;
+    state.entry.peersReturned = numPeers;
+    state.entry.lastError.clear();
+    state.demotedUntil = Clock::time_point();
+}
+
+void TrackerHealth::onError(const lt::torrent_handle& handle, const std::string& url, const std::string& error, bool reachable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    State& state = m_trackers[url];
+    state.entry.url = url;
+
+    finishAnnounce(state, handle, url, now);
+    state.entry.lastError = error;
+    if (reachable) {
+        // It answered, so the endpoint is alive; the failure is about this torrent
+        state.entry.failureStreak = 0;
+        state.demotedUntil = Clock::time_point();
+        return;
+    }
+
+    // The same outage seen by many torrents counts once
+    if (state.entry.failureStreak > 0 && now - state.lastCountedFailure < FAILURE_SPACING) {
+        return;
+    }
+    state.lastCountedFailure = now;
+    state.entry.failureStreak++;
+    if (state.entry.failureStreak >= DEMOTE_AFTER && now >= state.demotedUntil) {
+        state.demotedUntil = now + DEMOTION_PERIOD;
+    }
+}
+
+void TrackerHealth::onScrape(const std::string& url, int seeds, int leechers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    State& state = m_trackers[url];
+    state.entry.url = url;
+    state.entry.seeds = seeds;
+    state.entry.leechers = leechers;
+}
+
+bool TrackerHealth::isDemoted(const std::string& url) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_trackers.find(url);
+    return it != m_trackers.end() && Clock::now() < it->second.demotedUntil;
+}
+
+bool TrackerHealth::get(const std::string& url, Entry& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_trackers.find(url);
+    if (it == m_trackers.end()) {
+        return false;
+    }
+    out = snapshot(it->second, Clock::now());
+    return true;
+}
+
+std::vector<TrackerHealth::Entry> TrackerHealth::getAll() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    std::vector<Entry> entries;
+    entries.reserve(m_trackers.size());
+    for (const auto& [url, state] : m_trackers) {
+        entries.push_back(snapshot(state, now));
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.url < b.url;
+    });
+    return entries;
+}
+
+void TrackerHealth::finishAnnounce(State& state, const lt::torrent_handle& handle, const std::string& url, Clock::time_point now) {
+    auto it = m_pending.find(std::make_pair(url, handle));
+    if (it == m_pending.end()) {
+        return;
+    }
+    double ms = std::chrono::duration<double, std::milli>(now - it->second).count();
+    m_pending.erase(it);
+    state.latencyMs = state.latencyMs < 0 ? ms : state.latencyMs + LATENCY_SMOOTHING * (ms - state.latencyMs);
+}
+
+TrackerHealth::Entry TrackerHealth::snapshot(const State& state, Clock::time_point now) const {
+    Entry entry = state.entry;
+    entry.latencyMs = state.latencyMs < 0 ? -1 : static_cast<int>(state.latencyMs + 0.5);
+    entry.demoted = now < state.demotedUntil;
+    return entry;
+}
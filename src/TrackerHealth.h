@@ -0,0 +1,90 @@
+#ifndef TRACKERHEALTH_H
+#define TRACKERHEALTH_H
+
+#include <libtorrent/torrent_handle.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace lt = libtorrent;
+
+/**
+ * @brief How each tracker URL has been doing, across every torrent using it
+ *
+ * Fed from tracker_announce_alert, tracker_reply_alert, tracker_error_alert
+ * and scrape_reply_alert on the engine thread. Latency is the time from an
+ * announce going out to its reply or error, smoothed per URL.
+ *
+ * Only errors where the tracker never answered (timeouts, refused
+ * connections, DNS failures) count towards the failure streak; a tracker
+ * that replies with a failure reason is alive. Many torrents announce to
+ * the same tracker at once, so failures count at most once per
+ * FAILURE_SPACING: one network blip is one failure, not one per torrent.
+ * After DEMOTE_AFTER counted failures in a row, with no success from any
+ * torrent in between, the tracker is demoted for DEMOTION_PERIOD. The next
+ * counted failure after that demotes it again; any success clears the
+ * streak.
+ *
+ * Readable from any thread.
+ */
+class TrackerHealth {
+public:
+    struct Entry {
+        std::string url;
+        int latencyMs = -1;             // smoothed; -1 = no round trip seen yet
+        int64_t lastSuccess = 0;        // unix time, 0 = never
+        int failureStreak = 0;
+        int peersReturned = -1;         // in the last reply
+        int seeds = -1;                 // from the last scrape
+        int leechers = -1;
+        std::string lastError;
+        bool demoted = false;
+    };
+
+    void onAnnounce(const lt::torrent_handle& handle, const std::string& url);
+    void onReply(const lt::torrent_handle& handle, const std::string& url, int numPeers);
+    // reachable: the tracker answered with a failure reason
+    void onError(const lt::torrent_handle& handle, const std::string& url, const std::string& error, bool reachable);
+    void onScrape(const std::string& url, int seeds, int leechers);
+
+    bool isDemoted(const std::string& url) const;
+    bool get(const std::string& url, Entry& out) const;
+    std::vector<Entry> getAll() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    using PendingKey = std::pair<std::string, lt::torrent_handle>;
+
+    struct State {
+        Entry entry;
+        double latencyMs = -1.0;
+        Clock::time_point demotedUntil;
+        Clock::time_point lastCountedFailure;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, State> m_trackers;
+    // Announces waiting for their reply, to time the round trip. The queue
+    // holds them in the order sent so unanswered ones expire from its front.
+    std::map<PendingKey, Clock::time_point> m_pending;
+    std::deque<std::pair<Clock::time_point, PendingKey>> m_pendingOrder;
+
+    static constexpr int DEMOTE_AFTER = 5;
+    static constexpr std::chrono::minutes DEMOTION_PERIOD{60};
+    static constexpr std::chrono::minutes PENDING_TIMEOUT{5};
+    static constexpr std::chrono::minutes FAILURE_SPACING{2};
+    static constexpr double LATENCY_SMOOTHING = 0.25;
+
+    // Caller holds m_mutex
+    void finishAnnounce(State& state, const lt::torrent_handle& handle, const std::string& url, Clock::time_point now);
+    Entry snapshot(const State& state, Clock::time_point now) const;
+};
+
+#endif // TRACKERHEALTH_H
@@ -0,0 +1,113 @@
+#include "TrackerList.h"
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/announce_entry.hpp>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+TrackerList::TrackerList(const std::string& path)
+    : m_path(path)
+    , m_trackers(std::make_shared<const List>())
+    , m_mtime()
+    , m_exists(false)
+    , m_nextCheck()
+{
+}
+
+size_t TrackerList::apply(lt::add_torrent_params& params) {
+    std::shared_ptr<const List> trackers = current();
+    if (trackers->empty()) {
+        return 0;
+    }
+
+    // Resume data already carries the extra trackers added on a previous
+    // run, and a .torrent or magnet may list some of them itself
+    std::unordered_set<std::string> present(params.trackers.begin(), params.trackers.end());
+    if (params.ti) {
+        for (const auto& ae : params.ti->trackers()) {
+            present.insert(ae.url);
+        }
+    }
+
+    size_t added = 0;
+    for (const std::string& url : *trackers) {
+        if (present.count(url)) {
+            continue;
+        }
+        params.trackers.push_back(url);
+        // Same tier as add_tracker() gave them before
+        if (!params.tracker_tiers.empty()) {
+            params.tracker_tiers.resize(params.trackers.size(), 0);
+        }
+        added++;
+    }
+    return added;
+}
+
+size_t TrackerList::size() {
+    return current()->size();
+}
+
+std::string_view TrackerList::hostOf(std::string_view url) {
+    size_t start = url.find("://");
+    start = start == std::string_view::npos ? 0 : start + 3;
+    size_t end = url.find_first_of(":/?", start);
+    if (url.size() > start && url[start] == '[') {
+        // IPv6 literal
+        end = url.find(']', start);
+        if (end != std::string_view::npos) end++;
+    }
+    return url.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+}
+
+std::shared_ptr<const TrackerList::List> TrackerList::current() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_nextCheck) {
+        return m_trackers;
+    }
+    m_nextCheck = now + RELOAD_CHECK_INTERVAL;
+
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(m_path, ec);
+    bool exists = !ec;
+    if (exists == m_exists && (!exists || mtime == m_mtime)) {
+        return m_trackers;
+    }
+    m_exists = exists;
+    m_mtime = mtime;
+
+    m_trackers = std::make_shared<const List>(exists ? parse(m_path) : List());
+    if (exists) {
+        std::cout << "Loaded " << m_trackers->size() << " extra trackers from " << m_path << std::endl;
+    }
+    return m_trackers;
+}
+
+TrackerList::List TrackerList::parse(const std::string& path) {
+    List trackers;
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return trackers;
+    }
+
+    std::unordered_set<std::string> seen;
+    std::string line;
+    while (std::getline(file, line)) {
+        // Tolerate CRLF files and indentation
+        size_t begin = line.find_first_not_of(" \t\r");
+        size_t end = line.find_last_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            continue;
+        }
+        std::string tracker = line.substr(begin, end - begin + 1);
+        if (tracker.length() <= 5 || tracker[0] == '#') {
+            continue;
+        }
+        if (seen.insert(tracker).second) {
+            trackers.push_back(std::move(tracker));
+        }
+    }
+    return trackers;
+}
@@ -0,0 +1,56 @@
+#ifndef TRACKERLIST_H
+#define TRACKERLIST_H
+
+#include <libtorrent/add_torrent_params.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <filesystem>
+
+namespace lt = libtorrent;
+
+/**
+ * @brief The extra trackers from trackersadd.txt, loaded once and shared
+ *
+ * The file is parsed into a de-duplicated list the first time it is needed
+ * and parsed again only when its modification time changes (checked at
+ * most every RELOAD_CHECK_INTERVAL). apply() appends the trackers a torrent
+ * does not already have to its add_torrent_params, so they are part of the
+ * torrent from the start and go out with its first announce instead of
+ * being added, and reannounced, after the add.
+ *
+ * Thread-safe: the resume loader calls apply() from its worker threads.
+ */
+class TrackerList {
+public:
+    explicit TrackerList(const std::string& path);
+
+    // Adds the missing extra trackers to params.trackers; returns how many
+    size_t apply(lt::add_torrent_params& params);
+
+    size_t size();
+
+    // "udp://tracker.example.org:1337/announce" -> "tracker.example.org"
+    static std::string_view hostOf(std::string_view url);
+
+private:
+    using List = std::vector<std::string>;
+
+    std::string m_path;
+    std::mutex m_mutex;
+    std::shared_ptr<const List> m_trackers;     // never null
+    std::filesystem::file_time_type m_mtime;
+    bool m_exists;
+    std::chrono::steady_clock::time_point m_nextCheck;
+
+    static constexpr std::chrono::seconds RELOAD_CHECK_INTERVAL{5};
+
+    // Current list, reloaded first if the file changed
+    std::shared_ptr<const List> current();
+    static List parse(const std::string& path);
+};
+
+#endif // TRACKERLIST_H
@@ -3,10 +3,117 @@
 #include "TorrentManager.h"
 #include "SettingsManager.h"
 #include "Resources.h"
+#include "TorrentCreator.h"
+#include "HashBackend.h"
+#include "NumberFormat.h"
+#include "PiecePlanner.h"
 #include <memory>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+
+// ftorrent --create <file|dir> -o <out.torrent> [--piece-size KiB]
+//          [--tracker URL]... [--web-seed URL]... [--comment TEXT]
+//          [--private] [--format hybrid|v1|v2] [--threads N] [--hash-backend auto|sha-ni|libtorrent|scalar]
+// ftorrent --benchmark-hashing
+// ftorrent --benchmark-format
+// KiB on the command line; a power of two libtorrent accepts, in bytes
+static bool parsePieceSize(const char* text, int& bytes) {
+    char* end = nullptr;
+    long kib = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0'
+        || kib < PiecePlanner::MIN_PIECE_SIZE / 1024 || kib > PiecePlanner::MAX_PIECE_SIZE / 1024
+        || (kib & (kib - 1)) != 0) {
+        return false;
+    }
+    bytes = static_cast<int>(kib * 1024);
+    return true;
+}
+
+static int runCreateCommand(int argc, char **argv) {
+    TorrentCreator::Options options;
+    std::string output;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--create" && hasValue) options.source = argv[++i];
+        else if ((arg == "-o" || arg == "--output") && hasValue) output = argv[++i];
+        else if (arg == "--piece-size" && hasValue) {
+            if (!parsePieceSize(argv[++i], options.pieceSize)) {
+                std::cerr << "Invalid piece size: " << argv[i] << " (expected a power of two from "
+                          << PiecePlanner::MIN_PIECE_SIZE / 1024 << " to " << PiecePlanner::MAX_PIECE_SIZE / 1024
+                          << " KiB)" << std::endl;
+                return 2;
+            }
+        }
+        else if (arg == "--tracker" && hasValue) options.trackers.push_back(argv[++i]);
+        else if (arg == "--web-seed" && hasValue) options.webSeeds.push_back(argv[++i]);
+        else if (arg == "--comment" && hasValue) options.comment = argv[++i];
+        else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (arg == "--format" && hasValue) {
+            if (!TorrentCreator::parseFormat(argv[++i], options.format)) {
+                std::cerr << "Unknown format: " << argv[i] << " (expected hybrid, v1 or v2)" << std::endl;
+                return 2;
+            }
+        }
+        else if (arg == "--hash-backend" && hasValue) options.hashBackend = argv[++i];
+        else if (arg == "--private") options.isPrivate = true;
+        else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return 2;
+        }
+    }
+    if (options.source.empty() || output.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --create <file|dir> -o <out.torrent> [--piece-size KiB] "
+                  << "[--tracker URL]... [--web-seed URL]... [--comment TEXT] [--private] [--format hybrid|v1|v2] [--threads N] "
+                  << "[--hash-backend NAME]" << std::endl;
+        return 2;
+    }
+    
+    const HashBackend* backend = HashBackend::find(options.hashBackend);
+    if (!backend) {
+        std::cerr << "Hash backend not available: " << options.hashBackend << std::endl;
+        return 2;
+    }
+    std::cout << "Hashing with " << backend->name << std::endl;
+    
+    TorrentCreator creator;
+    creator.start(options, output);
+    while (creator.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        std::cout << "\r" << TorrentCreator::formatProgress(creator.getProgress()) << "    " << std::flush;
+    }
+    creator.wait();
+    std::cout << std::endl;
+    
+    if (!creator.succeeded()) {
+        std::cerr << "Error creating torrent: " << creator.getError() << std::endl;
+        return 1;
+    }
+    std::cout << "Created " << output << std::endl;
+    return 0;
+}
 
 int main(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--create") == 0) {
+            return runCreateCommand(argc, argv);
+        }
+        if (std::strcmp(argv[i], "--benchmark-hashing") == 0) {
+            return HashBackend::runBenchmark();
+        }
+        if (std::strcmp(argv[i], "--benchmark-format") == 0) {
+            return NumberFormat::runBenchmark();
+        }
+    }
+    
+    // Enable FLTK thread support: the manager's engine thread and helper
+    // threads hand work to the UI with Fl::awake()
+    Fl::lock();
+    
     // Initialize resources (icons, etc.)
     Resources::initialize();
     auto& settings = SettingsManager::instance();